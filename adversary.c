@@ -0,0 +1,151 @@
+/**
+ * Adversarial workload search.
+ * Hill-climbs over the parameters of one workload family (workload.h)
+ * to maximize a cost of the real allocator:
+ * - steps: free list nodes visited per mymalloc/myfree call
+ * - frag:  unused share of the mapped heap at its fullest point
+ * - mmap:  number of chunks mapped
+ * Each climb starts from random parameters, tries one mutated parameter
+ * per iteration and keeps the mutation when it does not lower the cost.
+ * The best case is printed as a workload_t initializer for bench.c.
+ *
+ * Usage: adversary [-f holes|churn] [-m steps|frag|mmap] [-i iters] [-r restarts] [-s seed]
+ */
+
+// importing neccesary libararies
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include "malloc.h"
+#include "workload.h"
+
+typedef enum { M_STEPS, M_FRAG, M_MMAP, NUM_METRICS } metric_t;
+
+static const char *metric_names[NUM_METRICS] = { "steps", "frag", "mmap" };
+
+static uint64_t rng_state = 88172645463325252ULL;
+
+static uint64_t rng(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+static long rng_range(long lo, long hi) {
+    return lo + (long)(rng() % (uint64_t)(hi - lo + 1));
+}
+
+static double cost(const workload_t *wl, metric_t metric) {
+    wl_result_t res;
+    if (wl_run(wl, &res) != 0) return -1.0;
+    switch (metric) {
+    case M_STEPS: return res.steps_per_op;
+    case M_FRAG:  return res.frag;
+    default:      return (double)res.nmmap;
+    }
+}
+
+/**
+ * Moves one parameter by a random step, or re-draws it
+ * Steps shrink with the range so that both coarse and fine moves happen.
+ */
+static void mutate(workload_t *wl) {
+    int i = rng() % WL_PARAMS;
+    long lo = wl_param_min[wl->family][i], hi = wl_param_max[wl->family][i];
+
+    if (rng() % 8 == 0) {
+        wl->p[i] = rng_range(lo, hi);
+        return;
+    }
+    long span = (hi - lo) >> (rng() % 6);
+    long step = rng_range(-span / 4 - 1, span / 4 + 1);
+    wl->p[i] += step;
+    if (wl->p[i] < lo) wl->p[i] = lo;
+    if (wl->p[i] > hi) wl->p[i] = hi;
+}
+
+static void usage(void) {
+    fprintf(stderr, "usage: adversary [-f holes|churn] [-m steps|frag|mmap] [-i iters] [-r restarts] [-s seed]\n");
+    exit(2);
+}
+
+//main function to run the search
+int main(int argc, char **argv) {
+    wl_family_t family = WL_HOLES;
+    metric_t metric = M_STEPS;
+    int iters = 200, restarts = 4;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "f:m:i:r:s:")) != -1) {
+        switch (opt) {
+        case 'f':
+            for (family = 0; family < WL_FAMILIES; family++) {
+                if (strcmp(optarg, wl_family_names[family]) == 0) break;
+            }
+            if (family == WL_FAMILIES) usage();
+            break;
+        case 'm':
+            for (metric = 0; metric < NUM_METRICS; metric++) {
+                if (strcmp(optarg, metric_names[metric]) == 0) break;
+            }
+            if (metric == NUM_METRICS) usage();
+            break;
+        case 'i':
+            iters = atoi(optarg);
+            break;
+        case 'r':
+            restarts = atoi(optarg);
+            break;
+        case 's':
+            rng_state = strtoull(optarg, NULL, 10) | 1;
+            break;
+        default:
+            usage();
+        }
+    }
+    if (optind != argc || iters < 1 || restarts < 1) usage();
+
+    wl_setup();
+
+    workload_t best = { NULL, family, { 0 } };
+    double best_cost = -1.0;
+
+    for (int r = 0; r < restarts; r++) {
+        workload_t cur = { NULL, family, { 0 } };
+        for (int i = 0; i < WL_PARAMS; i++) {
+            cur.p[i] = rng_range(wl_param_min[family][i], wl_param_max[family][i]);
+        }
+        double cur_cost = cost(&cur, metric);
+
+        for (int it = 0; it < iters; it++) {
+            workload_t next = cur;
+            mutate(&next);
+            double next_cost = cost(&next, metric);
+            // sideways moves are kept so the climb can cross plateaus
+            if (next_cost >= cur_cost) {
+                cur = next;
+                cur_cost = next_cost;
+            }
+        }
+
+        printf("restart %d: %s = %.4f\n", r, metric_names[metric], cur_cost);
+        if (cur_cost > best_cost) {
+            best = cur;
+            best_cost = cur_cost;
+        }
+    }
+
+    printf("best %s = %.4f (", metric_names[metric], best_cost);
+    for (int i = 0; i < WL_PARAMS; i++) {
+        printf("%s%s=%ld", i ? ", " : "", wl_param_names[family][i], best.p[i]);
+    }
+    printf(")\n");
+    printf("    { \"%s-%s\", %s, { %ld, %ld, %ld, %ld, %ld } },\n",
+           wl_family_names[family], metric_names[metric],
+           family == WL_HOLES ? "WL_HOLES" : "WL_CHURN",
+           best.p[0], best.p[1], best.p[2], best.p[3], best.p[4]);
+    return 0;
+}
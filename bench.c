@@ -0,0 +1,75 @@
+/**
+ * Allocator benchmark suite.
+ * Runs a fixed table of workloads (workload.h) against mymalloc and
+ * reports time and the allocator's own costs for each. The table holds
+ * friendly baselines next to the pathological cases found by adversary,
+ * so a change to placement or coalescing shows up on both kinds.
+ *
+ * Usage: bench [-n repeats] [name]
+ * With a name only that workload is run.
+ */
+
+// importing neccesary libararies
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "malloc.h"
+#include "workload.h"
+
+static const workload_t suite[] = {
+    // baselines: refills fit the holes, survivors are few and uniform
+    { "holes-fit",   WL_HOLES, { 1024, 64, 64, 4, 64 } },
+    { "churn-flat",  WL_CHURN, { 32, 256, 64, 64, 16 } },
+    // found with: adversary -f <family> -m <metric> -i 100 -r 3
+    { "holes-steps", WL_HOLES, { 1024, 2823, 3522, 12, 2703 } },
+    { "holes-frag",  WL_HOLES, { 16, 2078, 8, 12, 8 } },
+    { "holes-mmap",  WL_HOLES, { 1024, 194, 3660, 2, 3794 } },
+    { "churn-steps", WL_CHURN, { 32, 214, 53, 2822, 2 } },
+    { "churn-frag",  WL_CHURN, { 1, 8, 8, 7350, 8 } },
+    { "churn-mmap",  WL_CHURN, { 32, 256, 441, 7350, 4 } },
+};
+
+#define SUITE_SIZE (sizeof(suite) / sizeof(suite[0]))
+
+static void usage(void) {
+    fprintf(stderr, "usage: bench [-n repeats] [name]\n");
+    exit(2);
+}
+
+//main function to run the suite
+int main(int argc, char **argv) {
+    int repeats = 5;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+        case 'n':
+            repeats = atoi(optarg);
+            break;
+        default:
+            usage();
+        }
+    }
+    if (optind < argc - 1 || repeats < 1) usage();
+    const char *only = optind < argc ? argv[optind] : NULL;
+
+    wl_setup();
+
+    printf("%-12s %8s %10s %10s %8s %8s\n", "workload", "ops", "usec", "steps/op", "frag", "mmaps");
+    for (size_t w = 0; w < SUITE_SIZE; w++) {
+        if (only && strcmp(only, suite[w].name) != 0) continue;
+
+        // costs are deterministic; the time is the best of the repeats
+        wl_result_t res, run;
+        wl_run(&suite[w], &res);
+        for (int r = 1; r < repeats; r++) {
+            wl_run(&suite[w], &run);
+            if (run.seconds < res.seconds) res.seconds = run.seconds;
+        }
+
+        printf("%-12s %8zu %10.0f %10.2f %8.3f %8zu\n", suite[w].name, res.ops,
+               res.seconds * 1e6, res.steps_per_op, res.frag, res.nmmap);
+    }
+    return 0;
+}
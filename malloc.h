@@ -16,4 +16,38 @@ void *mymalloc(size_t size);
 void *mycalloc(size_t nmemb, size_t size);
 void myfree(void *ptr);
 
+/* Allocation for a hot call site: each site id recycles its own blocks */
+void *mymalloc_site(unsigned site_id, size_t size);
+void myfree_site(unsigned site_id, void *ptr);
+
+/* Per-thread allocation flags: while set, the calling thread's
+ * allocations come only from chunks mapped with them */
+#define MYMALLOC_LOCKED 0x1 /* pre-fault and mlock chunks */
+#define MYMALLOC_MERGEABLE 0x2 /* let KSM deduplicate identical pages */
+
+int mymalloc_setflags(int flags);
+
+/* Runtime control: read *oldp and/or apply *newp for a named parameter */
+int mymalloc_ctl(const char *name, void *oldp, void *newp);
+size_t mymalloc_trim(void);
+
+/* Free space totals read in one heap walk through "stats.heap_walk" */
+typedef struct mymalloc_walk {
+    size_t free_bytes;   /* payload bytes in free blocks */
+    size_t free_blocks;  /* number of free blocks */
+    size_t largest_free; /* largest single free block */
+} mymalloc_walk_t;
+
+/* FIFO ring allocator for objects released roughly in allocation order */
+typedef struct myring myring_t;
+
+myring_t *myring_create(size_t capacity);
+void *myring_alloc(myring_t *ring, size_t size);
+void myring_free(myring_t *ring, void *ptr);
+void myring_destroy(myring_t *ring);
+
+/* Ring buffer mapped twice back to back; size must be a page multiple */
+void *mymagic_ring_create(size_t size);
+void mymagic_ring_destroy(void *base, size_t size);
+
 #endif /* ifndef _MALLOC_H */
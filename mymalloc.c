@@ -4,16 +4,27 @@
  * - Block splitting for efficient memory usage
  * - Coalescing of free blocks
  * - Support for small and large memory allocations
- * - Thread-safe operations using mutex
+ * - Thread-safe operations using per-arena mutexes
+ * - Thread-local and pre-zeroed block caches, hot size classes
+ * - Per-call-site caches through mymalloc_site()/myfree_site()
+ * - Ring and double-mapped ring buffers
+ * - Runtime tuning and statistics through mymalloc_ctl()
  */
 
 // importing neccesary libararies
+#define _GNU_SOURCE // memfd_create
 #include <pthread.h>
 #include <stdio.h>
 #include <stdbool.h>
 #include <unistd.h>
 #include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <stddef.h>
 #include <sys/mman.h>
+#include "malloc.h"
 #ifndef MAP_ANONYMOUS
 #define MAP_ANONYMOUS 0x20
 #endif
@@ -27,198 +38,1984 @@
 typedef struct node {
     size_t size;
     bool free_flag;
+    bool cached;      // parked in an allocator cache, not live and not free
+    bool mmapped;     // dedicated mapping, not on the free list
+    bool hot;         // carved for a hot size class, not on the free list
+    bool calloced;    // handed out by mycalloc(), freed to the zero cache first
+    uint8_t arena;    // arena whose free list holds the block
+    uint8_t pins;     // maintenance walks resuming here; a pinned node stays listed
     struct node* next;
 } node_t;
 
-// Mutex for thread safety
+// Largest request whose header and page rounding cannot wrap size_t
+#define MAX_REQUEST (SIZE_MAX - sizeof(node_t) - PAGE_SIZE)
+
+// Mutex for thread safety of the tunables below
 pthread_mutex_t allocator_lock = PTHREAD_MUTEX_INITIALIZER;
-node_t *head = NULL;
 
 /**
- * Allocates memory with thread-safe mechanisms
- * 
- * @param size Requested memory size in bytes
- * @return Pointer to allocated memory or NULL if allocation fails
- * 
- * - For small allocations (<PAGE_SIZE):
- *   1. Search free list for suitable block
- *   2. Split block if significantly larger than request
- *   3. Allocate new page if no suitable block exists
- * - For large allocations (≥PAGE_SIZE):
- *   1. Allocate multiple pages using mmap
+ * Arena: an independent free list with its own lock
+ * Threads are spread over the arenas round robin, so allocating threads
+ * rarely contend, and maintenance passes (trim, purge, heap walks) hold
+ * one arena's lock at a time instead of stopping the whole heap.
+ * Allocations of a thread that has flags set come from a flag arena, one
+ * per flag combination, whose chunks were all mapped with those flags.
+ */
+#define MAX_ARENAS 16                           // arenas handed to threads
+#define HEAP_FLAGS (MYMALLOC_LOCKED | MYMALLOC_MERGEABLE)
+#define NUM_ARENAS (MAX_ARENAS + HEAP_FLAGS)    // plus one per flag combination
+#define WALK_BATCH 256                          // nodes visited per lock hold by trim and walks
+
+typedef struct arena {
+    pthread_mutex_t lock;
+    node_t *head;
+    int flags;        // MYMALLOC_* flags of every chunk in the arena
+} arena_t;
+
+static arena_t arenas[NUM_ARENAS] = {
+    [0 ... MAX_ARENAS - 1] = { PTHREAD_MUTEX_INITIALIZER, NULL, 0 },
+    [MAX_ARENAS + MYMALLOC_LOCKED - 1] = { PTHREAD_MUTEX_INITIALIZER, NULL, MYMALLOC_LOCKED },
+    [MAX_ARENAS + MYMALLOC_MERGEABLE - 1] = { PTHREAD_MUTEX_INITIALIZER, NULL, MYMALLOC_MERGEABLE },
+    [MAX_ARENAS + HEAP_FLAGS - 1] = { PTHREAD_MUTEX_INITIALIZER, NULL, HEAP_FLAGS },
+};
+
+#define FLAG_ARENA(flags) (MAX_ARENAS + (flags) - 1) // index of a flag arena
+static size_t narenas = 4;    // arenas handed out to new threads
+static size_t next_arena = 0; // round-robin cursor
+
+// Requests of at least this many bytes get a dedicated mapping
+static size_t mmap_threshold = PAGE_SIZE;
+// Small frees between automatic purges, 0 disables them
+static size_t purge_interval = 0;
+static size_t frees_since_purge = 0;
+
+/**
+ * Heap statistics
+ * Counters are updated with relaxed atomics because they are maintained
+ * under many different locks, and on lock-free paths. Counters stop while
+ * stats are disabled; the 'allocated' and 'mapped' gauges are always kept,
+ * since frees after re-enabling would otherwise drive them below zero.
+ */
+typedef struct heap_stats {
+    size_t nmalloc;          // successful allocations
+    size_t nfree;            // frees, including those parked in caches
+    size_t allocated;        // bytes in live blocks
+    size_t mapped;           // bytes currently mmap'd by the heap
+    size_t nmmap;            // chunks mapped
+    size_t search_steps;     // free list nodes visited by mymalloc()
+    size_t coalesce_steps;   // free list nodes visited by coalescing
+    size_t locked_fallbacks; // chunks that could not be mlock'd
+    size_t mergeable;        // bytes mapped with MYMALLOC_MERGEABLE
+    size_t mergeable_fallbacks; // chunks KSM could not be enabled for
+    size_t tcache_drained;   // thread cache blocks returned to the free list
+    size_t free_batches;     // locked passes over deferred frees
+    size_t hot_allocs;       // allocations served by hot size classes
+    size_t site_hits;        // allocations served by call-site caches
+    size_t zcache_hits;      // mycalloc() calls served pre-zeroed
+} heap_stats_t;
+
+static bool stats_enabled = true;
+static heap_stats_t heap_stats;
+
+#define STAT_ADD(field, n) do { \
+    if (__atomic_load_n(&stats_enabled, __ATOMIC_RELAXED)) __atomic_fetch_add(&heap_stats.field, (n), __ATOMIC_RELAXED); \
+} while (0)
+#define STAT_SUB(field, n) do { \
+    if (__atomic_load_n(&stats_enabled, __ATOMIC_RELAXED)) __atomic_fetch_sub(&heap_stats.field, (n), __ATOMIC_RELAXED); \
+} while (0)
+#define GAUGE_ADD(field, n) __atomic_fetch_add(&heap_stats.field, (n), __ATOMIC_RELAXED)
+#define GAUGE_SUB(field, n) __atomic_fetch_sub(&heap_stats.field, (n), __ATOMIC_RELAXED)
+
+/**
+ * Allocation trace recording
+ * When trace_fd is set, every mymalloc/mycalloc/myfree call appends one
+ * line to it, in the format read by the simulate tool:
+ *   m <ptr> <size>    mymalloc
+ *   c <ptr> <size>    mycalloc (total bytes)
+ *   f <ptr>           myfree
+ * Each record is a write() system call, so this is for capture runs only.
+ */
+static int trace_fd = -1;
+
+static void trace_record(char op, void *ptr, size_t size) {
+    char line[64];
+    int len;
+    if (op == 'f') {
+        len = snprintf(line, sizeof(line), "f %lx\n", (unsigned long)ptr);
+    } else {
+        len = snprintf(line, sizeof(line), "%c %lx %zu\n", op, (unsigned long)ptr, size);
+    }
+    if (write(trace_fd, line, len) != len) {
+        // A broken trace is useless; stop recording rather than retry
+        __atomic_store_n(&trace_fd, -1, __ATOMIC_RELAXED);
+    }
+}
+
+#define TRACE(op, ptr, size) do { \
+    if (__atomic_load_n(&trace_fd, __ATOMIC_RELAXED) >= 0) trace_record((op), (ptr), (size)); \
+} while (0)
+
+/**
+ * Maps a new chunk for the heap
+ *
+ * @param size Chunk size in bytes (page multiple)
+ * @param flags MYMALLOC_* flags to map the chunk with
+ * @return Pointer to the chunk or NULL if mmap fails
+ *
+ * - MYMALLOC_LOCKED: pages are pre-faulted with MAP_POPULATE and mlock'd.
+ *   If mlock fails the chunk is still handed out pre-faulted, it just may
+ *   be swapped out later.
+ * - MYMALLOC_MERGEABLE: the chunk is madvise(MADV_MERGEABLE)'d so KSM
+ *   can share identical pages between processes. Failure (kernel built
+ *   without KSM) is counted and otherwise ignored.
+ * Needs no lock.
+ */
+static void *map_chunk(size_t size, int flags) {
+    int map_flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    if (flags & MYMALLOC_LOCKED) map_flags |= MAP_POPULATE;
+
+    void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, map_flags, -1, 0);
+    if (ptr == MAP_FAILED) return NULL;
+
+    if ((flags & MYMALLOC_LOCKED) && mlock(ptr, size) != 0) {
+        STAT_ADD(locked_fallbacks, 1);
+    }
+    if (flags & MYMALLOC_MERGEABLE) {
+        if (madvise(ptr, size, MADV_MERGEABLE) != 0) {
+            STAT_ADD(mergeable_fallbacks, 1);
+        }
+        GAUGE_ADD(mergeable, size);
+    }
+    STAT_ADD(nmmap, 1);
+    GAUGE_ADD(mapped, size);
+    return ptr;
+}
+
+/**
+ * Returns a chunk (or a run of whole pages) to the kernel
+ *
+ * @param ptr Page-aligned start address
+ * @param size Length in bytes (page multiple)
+ * @param flags MYMALLOC_* flags the pages were mapped with
+ */
+static void unmap_chunk(void *ptr, size_t size, int flags) {
+    munmap(ptr, size);
+    GAUGE_SUB(mapped, size);
+    if (flags & MYMALLOC_MERGEABLE) GAUGE_SUB(mergeable, size);
+}
+
+/**
+ * Pre-zeroed block cache for small mycalloc() requests
+ * Small blocks that mycalloc() handed out, and the thread cache's
+ * overflow, are parked per size class when freed. Once a class has
+ * zcache_batch blocks pending, the freeing thread zeroes them all outside
+ * any lock and moves them to the ready stock, which mycalloc() pops
+ * without a memset.
+ */
+#define ZCACHE_MAX_SIZE 256                 // largest cached block size
+#define ZCACHE_CLASSES (ZCACHE_MAX_SIZE / 8) // one class per 8 bytes
+#define ZCACHE_DEPTH 8                      // max blocks per class, all states
+
+typedef struct zero_class {
+    node_t *ready[ZCACHE_DEPTH];   // zeroed, ready for mycalloc()
+    size_t nready;
+    node_t *pending[ZCACHE_DEPTH]; // freed, not zeroed yet
+    size_t npending;
+    size_t nzeroing;               // taken out by a thread that is zeroing them
+} zero_class_t;
+
+static pthread_mutex_t zero_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static zero_class_t zero_cache[ZCACHE_CLASSES];
+static size_t zcache_capacity = ZCACHE_DEPTH; // blocks per class, 0 disables
+static size_t zcache_batch = 4;               // blocks zeroed per pass
+
+/**
+ * Parks a freed block in the zero cache
+ *
+ * @param block Block being freed (size <= ZCACHE_MAX_SIZE)
+ * @return true if the block was taken by the cache
+ *
+ * When the class reaches zcache_batch pending blocks they are zeroed in
+ * one pass by the calling thread, with zero_cache_lock released.
+ */
+static bool zero_cache_stash(node_t *block) {
+    zero_class_t *zc = &zero_cache[block->size / 8 - 1];
+
+    pthread_mutex_lock(&zero_cache_lock);
+    if (block->free_flag || block->cached) {
+        printf("Double free detected!\n");
+        pthread_mutex_unlock(&zero_cache_lock);
+        return true;
+    }
+    if (zc->nready + zc->npending + zc->nzeroing >= zcache_capacity) {
+        pthread_mutex_unlock(&zero_cache_lock);
+        return false;
+    }
+
+    block->cached = true;
+    zc->pending[zc->npending++] = block;
+    STAT_ADD(nfree, 1);
+    GAUGE_SUB(allocated, block->size);
+
+    // A batch larger than the capacity would never fill up
+    size_t batch_size = zcache_batch < zcache_capacity ? zcache_batch : zcache_capacity;
+    if (zc->npending < batch_size) {
+        pthread_mutex_unlock(&zero_cache_lock);
+        return true;
+    }
+
+    // Take the whole batch and zero it without holding the lock
+    node_t *batch[ZCACHE_DEPTH];
+    size_t nbatch = zc->npending;
+    memcpy(batch, zc->pending, nbatch * sizeof(node_t *));
+    zc->npending = 0;
+    zc->nzeroing += nbatch;
+    pthread_mutex_unlock(&zero_cache_lock);
+
+    for (size_t i = 0; i < nbatch; i++) {
+        memset(batch[i] + 1, 0, batch[i]->size);
+    }
+
+    pthread_mutex_lock(&zero_cache_lock);
+    memcpy(&zc->ready[zc->nready], batch, nbatch * sizeof(node_t *));
+    zc->nready += nbatch;
+    zc->nzeroing -= nbatch;
+    pthread_mutex_unlock(&zero_cache_lock);
+    return true;
+}
+
+/**
+ * Pops a pre-zeroed block from the zero cache
+ *
+ * @param size Aligned request size (<= ZCACHE_MAX_SIZE)
+ * @return Zeroed block payload or NULL if the class is empty
+ */
+static void *zero_cache_pop(size_t size) {
+    zero_class_t *zc = &zero_cache[size / 8 - 1];
+    node_t *block = NULL;
+
+    pthread_mutex_lock(&zero_cache_lock);
+    if (zc->nready > 0) {
+        block = zc->ready[--zc->nready];
+        block->cached = false;
+    }
+    pthread_mutex_unlock(&zero_cache_lock);
+
+    if (!block) return NULL;
+    STAT_ADD(zcache_hits, 1);
+    STAT_ADD(nmalloc, 1);
+    GAUGE_ADD(allocated, block->size);
+    return (void *)(block + 1);
+}
+
+/**
+ * Thread-local block cache
+ * Each thread keeps small freed blocks in exact 8-byte size classes and
+ * reuses them without taking any lock. A pthread key destructor drains
+ * the cache back to the shared free list when the thread exits, so
+ * nothing stays stranded in a dead thread.
+ */
+#define TCACHE_MAX_SIZE 256                   // largest cached block size
+#define TCACHE_CLASSES (TCACHE_MAX_SIZE / 8)  // one class per 8 bytes
+#define TCACHE_DEPTH 16                       // max blocks per class
+
+#define FREE_BUFFER_SIZE 64                   // max deferred frees per thread
+
+/**
+ * Call-site cache
+ * A LIFO of blocks freed through myfree_site() for one site, all at
+ * least 'size' bytes, the aligned size the site last asked for.
+ */
+#define SITE_MAX 64   // site ids 0..SITE_MAX-1 are cached
+#define SITE_DEPTH 8  // max blocks per site
+
+typedef struct site_cache {
+    size_t size;      // aligned request size of the site, 0 if unused
+    node_t *blocks[SITE_DEPTH];
+    size_t count;
+} site_cache_t;
+
+typedef struct thread_cache {
+    node_t *bins[TCACHE_CLASSES][TCACHE_DEPTH];
+    size_t counts[TCACHE_CLASSES];
+    node_t *free_buf[FREE_BUFFER_SIZE]; // frees waiting for one locked pass
+    size_t nfree_buf;
+    site_cache_t sites[SITE_MAX]; // mymalloc_site() recycling
+    size_t sample_countdown; // allocations until the next size sample
+    size_t arena;            // 1 + index of this thread's arena, 0 if unset
+    int flags;               // MYMALLOC_* flags of this thread's allocations
+    bool registered; // exit destructor armed for this thread
+} thread_cache_t;
+
+static __thread thread_cache_t tcache;
+static pthread_key_t tcache_key;
+static pthread_once_t tcache_key_once = PTHREAD_ONCE_INIT;
+static size_t tcache_capacity = 8; // blocks per class, 0 disables
+static size_t free_batch = 0;      // frees buffered per locked pass, 0 disables
+static size_t site_max_bytes = 1 << 20; // cap on bytes parked in all site caches
+static size_t site_cached_bytes = 0;    // bytes parked in all site caches
+
+static void tcache_destructor(void *arg);
+static size_t free_buffer_flush(thread_cache_t *tc);
+
+static void tcache_key_init(void) {
+    pthread_key_create(&tcache_key, tcache_destructor);
+}
+
+/**
+ * Arms the exit destructor for the calling thread
+ * The destructor only runs for threads with a non-NULL key value.
+ */
+static void tcache_register(void) {
+    if (tcache.registered) return;
+    pthread_once(&tcache_key_once, tcache_key_init);
+    pthread_setspecific(tcache_key, &tcache);
+    tcache.registered = true;
+}
+
+/**
+ * Returns the calling thread's arena, assigning one on first use
+ */
+static arena_t *thread_arena(void) {
+    if (tcache.arena == 0) {
+        size_t n = __atomic_load_n(&narenas, __ATOMIC_RELAXED);
+        tcache.arena = __atomic_fetch_add(&next_arena, 1, __ATOMIC_RELAXED) % n + 1;
+    }
+    return &arenas[tcache.arena - 1];
+}
+
+/**
+ * Sets the calling thread's allocation flags
+ *
+ * @param flags Bitwise OR of MYMALLOC_* flags
+ * @return The thread's previous flags
+ *
+ * While flags are set, the thread's allocations are served only from
+ * chunks mapped with exactly these flags, kept in their own flag arena.
+ * They bypass the thread, zero, hot class and call-site caches, so they
+ * never receive memory from other chunks. Other threads are unaffected,
+ * and blocks allocated earlier keep the properties of their chunk.
+ */
+int mymalloc_setflags(int flags) {
+    int old_flags = tcache.flags;
+    tcache.flags = flags & HEAP_FLAGS;
+    return old_flags;
+}
+
+/**
+ * Caches a freed block in the calling thread
+ *
+ * @param block Block being freed (size <= TCACHE_MAX_SIZE)
+ * @return true if the block was cached
+ */
+static bool tcache_push(node_t *block) {
+    size_t c = block->size / 8 - 1;
+    if (tcache.counts[c] >= __atomic_load_n(&tcache_capacity, __ATOMIC_RELAXED)) return false;
+
+    tcache_register();
+    block->cached = true;
+    tcache.bins[c][tcache.counts[c]++] = block;
+    STAT_ADD(nfree, 1);
+    GAUGE_SUB(allocated, block->size);
+    return true;
+}
+
+/**
+ * Pops a cached block of exactly the requested size class
+ *
+ * @param size Aligned request size (<= TCACHE_MAX_SIZE)
+ * @return Block payload or NULL if the class is empty
+ */
+static void *tcache_pop(size_t size) {
+    size_t c = size / 8 - 1;
+    if (tcache.counts[c] == 0) return NULL;
+
+    node_t *block = tcache.bins[c][--tcache.counts[c]];
+    block->cached = false;
+    STAT_ADD(nmalloc, 1);
+    GAUGE_ADD(allocated, block->size);
+    return (void *)(block + 1);
+}
+
+/**
+ * Self-tuning hot size classes
+ * With sampling enabled, one in sample_interval requests records its
+ * aligned size in a histogram. After hot_warmup samples the most frequent
+ * sizes (each at least 1/HOT_MIN_SHARE of the samples) become hot
+ * classes: exact-size blocks carved back to back from dedicated slabs
+ * and recycled through per-slab free lists, with no search, no split
+ * remainder and no coalescing. A slab whose blocks are all free again is
+ * unmapped. Everything else keeps using the free list.
+ */
+#define HOT_MAX_SIZE 1024                   // largest size that can become hot
+#define HOT_BUCKETS (HOT_MAX_SIZE / 8)      // histogram buckets, 8 bytes each
+#define HOT_CLASSES 4                       // max hot classes
+#define HOT_MIN_SHARE 20                    // a hot size is >= 1/20 of samples
+#define HOT_SLAB_SIZE (PAGE_SIZE * 4)       // bytes per slab, which is aligned to it
+
+/**
+ * Hot slab header, at the start of each slab
+ * Slabs are aligned to HOT_SLAB_SIZE, so a block finds its slab by masking
+ * its address.
+ */
+typedef struct hot_slab {
+    struct hot_slab *prev, *next; // class's slabs holding freed blocks
+    node_t *free;                 // freed blocks, linked through next
+    size_t live;                  // blocks handed out
+} hot_slab_t;
+
+#define HOT_SLAB_OF(block) ((hot_slab_t *)((uintptr_t)(block) & ~(uintptr_t)(HOT_SLAB_SIZE - 1)))
+
+typedef struct hot_class {
+    pthread_mutex_t lock; // guards the fields below, except size
+    size_t size;        // exact block size
+    hot_slab_t *partial; // slabs holding freed blocks
+    hot_slab_t *current; // slab being carved, kept even when all free
+    char *carve;        // next unused byte in the current slab
+    size_t carve_left;  // bytes left in the current slab
+} hot_class_t;
+
+static bool sampling_enabled = false;
+static size_t sample_interval = 16;
+static size_t hot_warmup = 4096;
+static size_t hot_histogram[HOT_BUCKETS];
+static size_t hot_samples = 0;
+// Hot classes are only ever added, so blocks already carved stay valid.
+// hot_lock serialises fitting; each class has its own lock, so threads
+// allocating different hot sizes never contend.
+static pthread_mutex_t hot_lock = PTHREAD_MUTEX_INITIALIZER;
+static hot_class_t hot_classes[HOT_CLASSES] = {
+    [0 ... HOT_CLASSES - 1] = { .lock = PTHREAD_MUTEX_INITIALIZER },
+};
+static size_t nhot = 0;
+
+/**
+ * Finds the hot class of an exact block size
+ *
+ * @return The class, or NULL if the size is not hot
+ */
+static hot_class_t *hot_class_of(size_t size) {
+    size_t count = __atomic_load_n(&nhot, __ATOMIC_ACQUIRE);
+    for (size_t i = 0; i < count; i++) {
+        if (hot_classes[i].size == size) return &hot_classes[i];
+    }
+    return NULL;
+}
+
+/**
+ * Picks hot classes from the histogram and starts a new sampling round
+ *
+ * Sizes that are already hot are skipped; classes are added until
+ * HOT_CLASSES exist. Caller must hold hot_lock.
+ */
+static void hot_fit_locked(void) {
+    size_t total = 0;
+    size_t counts[HOT_BUCKETS];
+    for (size_t b = 0; b < HOT_BUCKETS; b++) {
+        counts[b] = __atomic_exchange_n(&hot_histogram[b], 0, __ATOMIC_RELAXED);
+        total += counts[b];
+    }
+    for (size_t i = 0; i < nhot; i++) {
+        counts[hot_classes[i].size / 8 - 1] = 0;
+    }
+
+    while (nhot < HOT_CLASSES && total > 0) {
+        size_t best = 0;
+        for (size_t b = 1; b < HOT_BUCKETS; b++) {
+            if (counts[b] > counts[best]) best = b;
+        }
+        if (counts[best] * HOT_MIN_SHARE < total) break;
+
+        hot_class_t *hc = &hot_classes[nhot];
+        hc->size = (best + 1) * 8;
+        hc->partial = NULL;
+        hc->current = NULL;
+        hc->carve = NULL;
+        hc->carve_left = 0;
+        counts[best] = 0;
+        // Publish the class only after it is initialised
+        __atomic_store_n(&nhot, nhot + 1, __ATOMIC_RELEASE);
+    }
+    __atomic_store_n(&hot_samples, 0, __ATOMIC_RELAXED);
+}
+
+/**
+ * Records the aligned size of one in sample_interval requests
+ *
+ * @param size Aligned request size, 1..HOT_MAX_SIZE to be recorded
+ */
+static void hot_sample(size_t size) {
+    if (tcache.sample_countdown > 1) {
+        tcache.sample_countdown--;
+        return;
+    }
+    tcache.sample_countdown = __atomic_load_n(&sample_interval, __ATOMIC_RELAXED);
+    // Size 0 has no bucket; heap_alloc() never passes it, but a wrapped
+    // size must not index hot_histogram[-1]
+    if (size == 0 || size > HOT_MAX_SIZE) return;
+
+    __atomic_fetch_add(&hot_histogram[size / 8 - 1], 1, __ATOMIC_RELAXED);
+    size_t samples = __atomic_add_fetch(&hot_samples, 1, __ATOMIC_RELAXED);
+    if (samples < __atomic_load_n(&hot_warmup, __ATOMIC_RELAXED)) return;
+
+    // >= so that lowering hot.warmup below the count still fits; the
+    // thread that claims the samples back to 0 is the one that fits
+    if (__atomic_compare_exchange_n(&hot_samples, &samples, 0, false,
+                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        pthread_mutex_lock(&hot_lock);
+        hot_fit_locked();
+        pthread_mutex_unlock(&hot_lock);
+    }
+}
+
+/**
+ * Maps a slab aligned to HOT_SLAB_SIZE
+ *
+ * @return The slab, header cleared, or NULL if mmap fails
+ *
+ * Twice the size is mapped and the unaligned ends are unmapped again.
+ */
+static hot_slab_t *hot_slab_map(void) {
+    char *raw = map_chunk(2 * HOT_SLAB_SIZE, 0);
+    if (raw == NULL) return NULL;
+
+    char *slab = (char *)(((uintptr_t)raw + HOT_SLAB_SIZE - 1) & ~(uintptr_t)(HOT_SLAB_SIZE - 1));
+    char *end = raw + 2 * HOT_SLAB_SIZE;
+    if (slab > raw) unmap_chunk(raw, slab - raw, 0);
+    if (end > slab + HOT_SLAB_SIZE) unmap_chunk(slab + HOT_SLAB_SIZE, end - (slab + HOT_SLAB_SIZE), 0);
+
+    memset(slab, 0, sizeof(hot_slab_t));
+    return (hot_slab_t *)slab;
+}
+
+// Removes a slab from its class's partial list. Caller must hold hc->lock.
+static void hot_slab_unlink(hot_class_t *hc, hot_slab_t *slab) {
+    if (slab->prev) {
+        slab->prev->next = slab->next;
+    } else {
+        hc->partial = slab->next;
+    }
+    if (slab->next) slab->next->prev = slab->prev;
+    slab->prev = slab->next = NULL;
+}
+
+/**
+ * Allocates an exact-size block from a hot class
+ *
+ * @param hc Hot class matching the aligned request size
+ * @return Pointer to allocated memory or NULL if a new slab cannot be mapped
+ *
+ * Freed blocks are reused before new ones are carved.
+ * Caller must hold hc->lock.
+ */
+static void *hot_alloc_locked(hot_class_t *hc) {
+    hot_slab_t *slab = hc->partial;
+    node_t *block;
+
+    if (slab != NULL) {
+        block = slab->free;
+        slab->free = block->next;
+        if (slab->free == NULL) hot_slab_unlink(hc, slab);
+    } else {
+        size_t stride = sizeof(node_t) + hc->size;
+        if (hc->carve_left < stride) {
+            slab = hot_slab_map();
+            if (slab == NULL) return NULL;
+            hc->current = slab;
+            hc->carve = (char *)(slab + 1);
+            hc->carve_left = HOT_SLAB_SIZE - sizeof(hot_slab_t);
+        }
+        slab = hc->current;
+        block = (node_t *)hc->carve;
+        hc->carve += stride;
+        hc->carve_left -= stride;
+        block->size = hc->size;
+        block->mmapped = false;
+        block->hot = true;
+        block->calloced = false;
+    }
+
+    slab->live++;
+    block->free_flag = false;
+    block->cached = false;
+    block->next = NULL;
+    STAT_ADD(hot_allocs, 1);
+    STAT_ADD(nmalloc, 1);
+    GAUGE_ADD(allocated, block->size);
+    return (void *)(block + 1);
+}
+
+/**
+ * Returns a hot block to its slab
+ *
+ * @param hc Class of the block
+ * @param block Validated block with the hot flag set
+ * @return The block's slab if it is now entirely free and must be
+ *         unmapped (with unmap_chunk, after dropping hc->lock), else NULL
+ *
+ * Caller must hold hc->lock.
+ */
+static hot_slab_t *hot_free_locked(hot_class_t *hc, node_t *block) {
+    hot_slab_t *slab = HOT_SLAB_OF(block);
+
+    block->free_flag = true;
+    if (--slab->live == 0 && slab != hc->current) {
+        if (slab->free != NULL) hot_slab_unlink(hc, slab);
+        return slab;
+    }
+
+    if (slab->free == NULL) {
+        slab->next = hc->partial;
+        if (hc->partial) hc->partial->prev = slab;
+        hc->partial = slab;
+    }
+    block->next = slab->free;
+    slab->free = block;
+    return NULL;
+}
+
+/**
+ * Allocates memory with thread-safe mechanisms
+ * 
+ * @param size Requested memory size in bytes
+ * @return Pointer to allocated memory or NULL if allocation fails
+ * 
+ * - For small allocations (<mmap_threshold):
+ *   0. Reuse a block from the calling thread's cache if one fits exactly,
+ *      or carve it from a hot size class slab
+ *   1. Search free list for suitable block
+ *   2. Split block if significantly larger than request
+ *   3. Allocate new page(s) if no suitable block exists
+ * - For large allocations (≥mmap_threshold):
+ *   1. Allocate multiple pages using mmap
+ */
+static void *heap_alloc(size_t size) {
+    // Initial input validation and size alignment
+    if (size == 0) return NULL;
+    // Also keeps the rounding below from wrapping for huge sizes
+    if (size > MAX_REQUEST) return NULL;
+
+    // Minimum allocation size
+    size = (size < sizeof(void*)) ? sizeof(void*) : size;
+    size = (size + 7) & ~7; // Align size
+
+    if (__atomic_load_n(&sampling_enabled, __ATOMIC_RELAXED)) hot_sample(size);
+
+    // Flagged requests only take blocks from chunks mapped with the flags
+    int flags = tcache.flags;
+
+    // Thread cache hit: no lock, no search
+    if (size <= TCACHE_MAX_SIZE && flags == 0) {
+        void *cached = tcache_pop(size);
+        if (cached) return cached;
+    }
+
+    // Large allocation: directly map memory using mmap
+    if (size >= __atomic_load_n(&mmap_threshold, __ATOMIC_RELAXED)) {
+        size_t total_size = size + sizeof(node_t);
+        size_t pages_needed = (total_size + PAGE_SIZE - 1) / PAGE_SIZE;
+        size_t alloc_size = pages_needed * PAGE_SIZE;
+
+        void *ptr = map_chunk(alloc_size, flags);
+        if (ptr == NULL) return NULL;
+
+        // Create and configure metadata for large block
+        node_t *large_block = (node_t *)ptr;
+        large_block->size = alloc_size - sizeof(node_t);
+        large_block->free_flag = false;
+        large_block->cached = false;
+        large_block->mmapped = true;
+        large_block->hot = false;
+        large_block->calloced = false;
+        large_block->arena = flags ? FLAG_ARENA(flags) : 0;
+        large_block->pins = 0;
+        large_block->next = NULL;
+
+        STAT_ADD(nmalloc, 1);
+        GAUGE_ADD(allocated, large_block->size);
+        return (void *)(large_block + 1);
+    }
+
+    // Hot size class: exact fit from a slab, no search
+    hot_class_t *hc = flags ? NULL : hot_class_of(size);
+    if (hc) {
+        pthread_mutex_lock(&hc->lock);
+        void *ptr = hot_alloc_locked(hc);
+        pthread_mutex_unlock(&hc->lock);
+        return ptr;
+    }
+
+    arena_t *arena = flags ? &arenas[FLAG_ARENA(flags)] : thread_arena();
+    pthread_mutex_lock(&arena->lock);
+
+    for (;;) {
+        // Small allocation: search and potentially split free list blocks
+        node_t *current = arena->head;
+        size_t steps = 0;
+
+        while (current != NULL) {
+            steps++;
+            // Find suitable free block and potentially split it
+            if (current->free_flag && current->size >= size) {
+                // Detailed splitting logic
+                if (current->size >= size + sizeof(node_t) + 8) {
+                    node_t *new_block = (node_t *)((char *)(current + 1) + size);
+                    new_block->size = current->size - size - sizeof(node_t);
+                    new_block->free_flag = true;
+                    new_block->cached = false;
+                    new_block->mmapped = false;
+                    new_block->hot = false;
+                    new_block->calloced = false;
+                    new_block->arena = current->arena;
+                    new_block->pins = 0;
+                    new_block->next = current->next;
+
+                    // Insert new block into free list right after current,
+                    // which stays listed so it can coalesce once freed
+                    current->size = size;
+                    current->free_flag = false;
+                    current->next = new_block;
+                } else {
+                    current->free_flag = false;
+                }
+                STAT_ADD(search_steps, steps);
+                STAT_ADD(nmalloc, 1);
+                GAUGE_ADD(allocated, current->size);
+                pthread_mutex_unlock(&arena->lock);
+                return (void *)(current + 1);
+            }
+            current = current->next;
+        }
+        STAT_ADD(search_steps, steps);
+
+        // Deferred frees of this thread may hold a fit: release them and
+        // search again. They are never flagged, so flagged requests skip this.
+        if (flags != 0 || tcache.nfree_buf == 0) break;
+        pthread_mutex_unlock(&arena->lock);
+        free_buffer_flush(&tcache);
+        pthread_mutex_lock(&arena->lock);
+    }
+
+    // No suitable block: allocate new page
+    size_t total_size = size + sizeof(node_t);
+    size_t alloc_size = (total_size + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+
+    void *ptr = map_chunk(alloc_size, arena->flags);
+    if (ptr == NULL) {
+        pthread_mutex_unlock(&arena->lock);
+        return NULL;
+    }
+
+    // Create new block and link to free list
+    node_t *new_block = (node_t *)ptr;
+    new_block->size = alloc_size - sizeof(node_t);
+    new_block->free_flag = false;
+    new_block->cached = false;
+    new_block->mmapped = false;
+    new_block->hot = false;
+    new_block->calloced = false;
+    new_block->arena = (uint8_t)(arena - arenas);
+    new_block->pins = 0;
+    new_block->next = arena->head;
+    arena->head = new_block;
+
+    // Keep the rest of the chunk for later requests of this arena
+    if (new_block->size >= size + sizeof(node_t) + 8) {
+        node_t *rest = (node_t *)((char *)(new_block + 1) + size);
+        rest->size = new_block->size - size - sizeof(node_t);
+        rest->free_flag = true;
+        rest->cached = false;
+        rest->mmapped = false;
+        rest->hot = false;
+        rest->calloced = false;
+        rest->arena = new_block->arena;
+        rest->pins = 0;
+        rest->next = new_block->next;
+
+        new_block->size = size;
+        new_block->next = rest;
+    }
+
+    STAT_ADD(nmalloc, 1);
+    GAUGE_ADD(allocated, new_block->size);
+    pthread_mutex_unlock(&arena->lock);
+    return (void *)(new_block + 1);
+}
+
+/**
+ * Allocates memory (see heap_alloc) and records the call when tracing
+ *
+ * @param size Requested memory size in bytes
+ * @return Pointer to allocated memory or NULL if allocation fails
+ */
+void *mymalloc(size_t size) {
+    void *ptr = heap_alloc(size);
+    TRACE('m', ptr, size);
+    return ptr;
+}
+
+/**
+ * Merges every run of adjacent free blocks on an arena's free list
+ *
+ * @param arena Arena to coalesce
+ *
+ * Pinned nodes may absorb their successor but are never merged away.
+ * Caller must hold arena->lock.
+ */
+static void coalesce_locked(arena_t *arena) {
+    // More robust coalescing
+    node_t *current = arena->head;
+    node_t *prev = NULL;
+    size_t steps = 0;
+
+    while (current != NULL) {
+        steps++;
+        // Advanced coalescing logic
+        if (current->free_flag) {
+            // Check if current can merge with next block
+            if (current->next && 
+                current->next->free_flag && current->next->pins == 0 &&
+                (char*)current + sizeof(node_t) + current->size == (char*)current->next) {
+                
+                current->size += sizeof(node_t) + current->next->size;
+                current->next = current->next->next;
+                continue;  // Restart check
+            }
+
+            // Check if previous block can merge with current
+            if (prev && prev->free_flag && current->pins == 0 &&
+                (char*)prev + sizeof(node_t) + prev->size == (char*)current) {
+                
+                prev->size += sizeof(node_t) + current->size;
+                prev->next = current->next;
+                current = prev;
+                continue;
+            }
+        }
+
+        prev = current;
+        current = current->next;
+    }
+    STAT_ADD(coalesce_steps, steps);
+}
+
+/**
+ * Marks a small block free and coalesces the free list
+ *
+ * @param block_to_free Validated block that lives on the free list
+ *
+ * Caller must hold the lock of the block's arena.
+ */
+static void free_block_locked(node_t *block_to_free) {
+    block_to_free->free_flag = true;
+    coalesce_locked(&arenas[block_to_free->arena]);
+}
+
+/**
+ * Finds the whole pages inside a block's payload
+ *
+ * @return true if there is at least one, with [*start, *end) set to them
+ */
+static bool payload_pages(node_t *block, uintptr_t *start, uintptr_t *end) {
+    *start = ((uintptr_t)(block + 1) + PAGE_SIZE - 1) & ~(uintptr_t)(PAGE_SIZE - 1);
+    *end = ((uintptr_t)(block + 1) + block->size) & ~(uintptr_t)(PAGE_SIZE - 1);
+    return *end > *start;
+}
+
+/**
+ * Releases the physical pages inside an arena's free blocks
+ *
+ * @param arena Arena to purge
+ * @return Number of bytes purged
+ *
+ * Whole pages in each free block's payload are dropped with
+ * MADV_DONTNEED; the mappings (and block headers) stay in place.
+ * Arenas of MYMALLOC_LOCKED chunks are never purged. At most WALK_BATCH
+ * nodes are visited per hold of the arena lock. The blocks to purge are
+ * parked (cached, not free) so nothing allocates them, and madvise'd
+ * after the lock is dropped. Caller must hold no arena lock.
+ */
+static size_t purge_arena(arena_t *arena) {
+    size_t purged = 0;
+
+    // Locked memory has to stay resident
+    if (arena->flags & MYMALLOC_LOCKED) return 0;
+
+    pthread_mutex_lock(&arena->lock);
+    node_t *current = arena->head;
+
+    for (;;) {
+        node_t *parked[WALK_BATCH];
+        size_t nparked = 0;
+        node_t *last = NULL;
+
+        for (size_t visited = 0; current != NULL && visited < WALK_BATCH; visited++) {
+            uintptr_t start, end;
+            if (current->free_flag && payload_pages(current, &start, &end)) {
+                current->free_flag = false;
+                current->cached = true;
+                parked[nparked++] = current;
+            }
+            last = current;
+            current = current->next;
+        }
+
+        // Resume after last, which stays listed while it is pinned
+        bool more = current != NULL;
+        if (more) last->pins++;
+        pthread_mutex_unlock(&arena->lock);
+
+        for (size_t i = 0; i < nparked; i++) {
+            uintptr_t start, end;
+            payload_pages(parked[i], &start, &end);
+            if (madvise((void *)start, end - start, MADV_DONTNEED) == 0) {
+                purged += end - start;
+            }
+        }
+
+        pthread_mutex_lock(&arena->lock);
+        // Parked blocks skipped any merges meanwhile; the next free's
+        // coalescing pass picks those up
+        for (size_t i = 0; i < nparked; i++) {
+            parked[i]->cached = false;
+            parked[i]->free_flag = true;
+        }
+        if (!more) break;
+        last->pins--;
+        current = last->next;
+    }
+    pthread_mutex_unlock(&arena->lock);
+    return purged;
+}
+
+/**
+ * Counts frees towards opt.purge_interval and purges when it is reached
+ *
+ * @param arena Arena the frees went to, purged if the interval is reached
+ * @param nfreed Number of blocks just freed
+ *
+ * Caller must hold no arena lock.
+ */
+static void purge_tick(arena_t *arena, size_t nfreed) {
+    size_t interval = __atomic_load_n(&purge_interval, __ATOMIC_RELAXED);
+    if (interval == 0) return;
+
+    if (__atomic_add_fetch(&frees_since_purge, nfreed, __ATOMIC_RELAXED) >= interval) {
+        __atomic_store_n(&frees_since_purge, 0, __ATOMIC_RELAXED);
+        purge_arena(arena);
+    }
+}
+
+/**
+ * Releases a batch of blocks with one coalescing pass per arena
+ *
+ * @param blocks Validated blocks, cached flag still set; the array is
+ *               reordered in place
+ * @param count Number of blocks
+ * @return Number of payload bytes released
+ *
+ * Takes each arena and hot class lock as needed; caller holds none.
+ */
+static size_t free_blocks(node_t **blocks, size_t count) {
+    size_t pending = 0, bytes = 0;
+
+    // Dedicated mappings and hot blocks never touch an arena
+    for (size_t i = 0; i < count; i++) {
+        node_t *block = blocks[i];
+        bytes += block->size;
+        block->cached = false;
+        block->calloced = false;
+        if (block->mmapped) {
+            unmap_chunk(block, block->size + sizeof(node_t), arenas[block->arena].flags);
+        } else if (block->hot) {
+            hot_class_t *hc = hot_class_of(block->size);
+            pthread_mutex_lock(&hc->lock);
+            hot_slab_t *empty = hot_free_locked(hc, block);
+            pthread_mutex_unlock(&hc->lock);
+            if (empty) unmap_chunk(empty, HOT_SLAB_SIZE, 0);
+        } else {
+            blocks[pending++] = block;
+        }
+    }
+
+    // One lock and one coalescing pass for each arena in the batch
+    while (pending > 0) {
+        arena_t *arena = &arenas[blocks[0]->arena];
+        size_t kept = 0, nfreed = 0;
+
+        pthread_mutex_lock(&arena->lock);
+        for (size_t i = 0; i < pending; i++) {
+            if (&arenas[blocks[i]->arena] == arena) {
+                blocks[i]->free_flag = true;
+                nfreed++;
+            } else {
+                blocks[kept++] = blocks[i];
+            }
+        }
+        coalesce_locked(arena);
+        pthread_mutex_unlock(&arena->lock);
+        purge_tick(arena, nfreed);
+        pending = kept;
+    }
+    return bytes;
+}
+
+/**
+ * Processes a thread's deferred frees in one batch
+ *
+ * @param tc Thread state whose buffer is emptied
+ */
+static size_t free_buffer_flush(thread_cache_t *tc) {
+    size_t bytes = free_blocks(tc->free_buf, tc->nfree_buf);
+    tc->nfree_buf = 0;
+    STAT_ADD(free_batches, 1);
+    return bytes;
+}
+
+/**
+ * Frees previously allocated memory
+ * 
+ * @param ptr Pointer to memory block to be freed
+ * 
+ * - For small blocks: 
+ *   1. Keep it in the thread cache, or else park it in the zero cache,
+ *      if it is small enough, there is room and it is not from a flag arena.
+ *      Blocks that mycalloc() handed out try the zero cache first, so the
+ *      next mycalloc() of their size finds them already zeroed
+ *   2. With opt.free_batch set, buffer it until the batch is full, then
+ *      release the whole batch with one lock and one coalescing pass
+ *   3. Otherwise mark block as free and coalesce adjacent free blocks
+ * - For large blocks:
+ *   1. Unmap memory using munmap
+ */
+void myfree(void *ptr) {
+    if (!ptr) return;
+    TRACE('f', ptr, 0);
+
+    node_t *block_to_free = (node_t *)ptr - 1;
+    // Blocks of flag arenas skip the caches, which feed unflagged requests
+    bool flagged = arenas[block_to_free->arena].flags != 0;
+    bool calloced = block_to_free->calloced;
+    block_to_free->calloced = false;
+
+    // Sizes mycalloc() asks for are zeroed here, off its allocation path
+    if (calloced && block_to_free->size <= ZCACHE_MAX_SIZE && !flagged &&
+        zero_cache_stash(block_to_free)) {
+        return;
+    }
+
+    // Other small blocks go to this thread's cache first
+    if (block_to_free->size <= TCACHE_MAX_SIZE && !flagged) {
+        if (block_to_free->free_flag || block_to_free->cached) {
+            printf("Double free detected!\n");
+            return;
+        }
+        if (tcache_push(block_to_free)) return;
+    }
+
+    // The thread cache's overflow is zeroed for mycalloc() too
+    if (!calloced && block_to_free->size <= ZCACHE_MAX_SIZE && !flagged &&
+        zero_cache_stash(block_to_free)) {
+        return;
+    }
+
+    // Batched free: defer the lock and the coalescing pass
+    size_t batch_size = __atomic_load_n(&free_batch, __ATOMIC_RELAXED);
+    if (batch_size != 0 && !flagged) {
+        if (block_to_free->free_flag || block_to_free->cached) {
+            printf("Double free detected!\n");
+            return;
+        }
+        tcache_register();
+        block_to_free->cached = true;
+        tcache.free_buf[tcache.nfree_buf++] = block_to_free;
+        STAT_ADD(nfree, 1);
+        GAUGE_SUB(allocated, block_to_free->size);
+        if (tcache.nfree_buf >= batch_size) free_buffer_flush(&tcache);
+        return;
+    }
+
+    // Dedicated mappings and hot blocks are not on any arena's free list
+    arena_t *arena = &arenas[block_to_free->arena];
+    hot_class_t *hc = block_to_free->hot ? hot_class_of(block_to_free->size) : NULL;
+    pthread_mutex_t *lock = block_to_free->mmapped ? NULL :
+                            hc ? &hc->lock :
+                            &arena->lock;
+    if (lock) pthread_mutex_lock(lock);
+    
+    // Validate block before freeing
+    if (block_to_free->free_flag || block_to_free->cached) {
+        printf("Double free detected!\n");
+        if (lock) pthread_mutex_unlock(lock);
+        return;
+    }
+
+    STAT_ADD(nfree, 1);
+    GAUGE_SUB(allocated, block_to_free->size);
+
+    // Large allocation handling remains the same
+    if (block_to_free->mmapped) {
+        unmap_chunk(block_to_free, block_to_free->size + sizeof(node_t), arena->flags);
+        return;
+    }
+
+    if (hc) {
+        hot_slab_t *empty = hot_free_locked(hc, block_to_free);
+        pthread_mutex_unlock(lock);
+        if (empty) unmap_chunk(empty, HOT_SLAB_SIZE, 0);
+        return;
+    }
+
+    free_block_locked(block_to_free);
+
+    // The block may be merged away once the lock is dropped
+    pthread_mutex_unlock(lock);
+    purge_tick(arena, 1);
+}
+
+/**
+ * Allocates and initializes memory to zero
+ * 
+ * @param nmemb Number of elements
+ * @param s Size of each element
+ * @return Pointer to zeroed memory block
+ */
+void *mycalloc(size_t nmemb, size_t s) {
+    if (s != 0 && nmemb > (size_t)-1 / s) return NULL; // nmemb * s overflows
+    size_t total_size = nmemb * s; // Calculate total memory size needed by multiplying number of elements and element size
+    if (total_size == 0) return NULL;
+    // Also keeps the alignment below from wrapping for huge sizes
+    if (total_size > MAX_REQUEST) return NULL;
+
+    // Small request: take a block that was zeroed when it was freed
+    size_t aligned = (total_size < sizeof(void*)) ? sizeof(void*) : total_size;
+    aligned = (aligned + 7) & ~7;
+    if (aligned <= ZCACHE_MAX_SIZE && tcache.flags == 0) {
+        void *cached = zero_cache_pop(aligned);
+        if (cached) {
+            ((node_t *)cached - 1)->calloced = true;
+            TRACE('c', cached, total_size);
+            return cached;
+        }
+    }
+
+    void *p = heap_alloc(total_size); // Allocate memory
+    if (!p) return NULL;
+    // Dedicated mappings are always fresh pages, hence already zero
+    if (!((node_t *)p - 1)->mmapped) {
+        memset(p, 0, total_size);// Initialize allocated memory to zero using memset
+    }
+    ((node_t *)p - 1)->calloced = true;
+    TRACE('c', p, total_size);
+    return p;
+}
+
+/**
+ * Returns every block parked in one call-site cache to the free list
+ *
+ * @param sc Site cache of the calling (or exiting) thread
+ * @return Number of bytes released
+ */
+static size_t site_flush(site_cache_t *sc) {
+    size_t bytes = free_blocks(sc->blocks, sc->count);
+    sc->count = 0;
+    __atomic_fetch_sub(&site_cached_bytes, bytes, __ATOMIC_RELAXED);
+    return bytes;
+}
+
+/**
+ * Allocates memory for a known call site
+ *
+ * @param site_id Caller-chosen id of the call site, below SITE_MAX to be cached
+ * @param size Number of bytes to allocate
+ * @return Pointer to allocated memory or NULL if allocation fails
+ *
+ * A hit pops the block the site freed last, with no size class lookup,
+ * no lock and no search. A site is expected to ask for one size; when the
+ * size changes, the blocks cached for the old size are released first.
+ * Misses, site ids outside the cache and requests of a thread with flags
+ * set go through mymalloc().
+ */
+void *mymalloc_site(unsigned site_id, size_t size) {
+    if (size == 0 || site_id >= SITE_MAX || tcache.flags != 0) {
+        return mymalloc(size);
+    }
+
+    size_t aligned = (size < sizeof(void*)) ? sizeof(void*) : size;
+    aligned = (aligned + 7) & ~7;
+
+    site_cache_t *sc = &tcache.sites[site_id];
+    if (sc->size == aligned && sc->count > 0) {
+        node_t *block = sc->blocks[--sc->count];
+        block->cached = false;
+        __atomic_fetch_sub(&site_cached_bytes, block->size, __ATOMIC_RELAXED);
+        STAT_ADD(nmalloc, 1);
+        GAUGE_ADD(allocated, block->size);
+        STAT_ADD(site_hits, 1);
+        TRACE('m', block + 1, size);
+        return (void *)(block + 1);
+    }
+
+    if (sc->size != aligned) {
+        site_flush(sc);
+        sc->size = aligned;
+    }
+    return mymalloc(size);
+}
+
+/**
+ * Frees memory allocated for a call site
+ *
+ * @param site_id Id the block was allocated with through mymalloc_site()
+ * @param ptr Pointer to the memory to free
+ *
+ * The block is parked in the site's cache of the calling thread while
+ * the cache has room and all site caches together stay within
+ * "site.max_bytes"; otherwise it is freed through myfree().
+ */
+void myfree_site(unsigned site_id, void *ptr) {
+    if (!ptr) return;
+    if (site_id >= SITE_MAX) {
+        myfree(ptr);
+        return;
+    }
+
+    node_t *block = (node_t *)ptr - 1;
+    if (block->free_flag || block->cached) {
+        printf("Double free detected!\n");
+        return;
+    }
+
+    site_cache_t *sc = &tcache.sites[site_id];
+    if (sc->count >= SITE_DEPTH || sc->size == 0 || block->size < sc->size ||
+        arenas[block->arena].flags != 0) {
+        myfree(ptr);
+        return;
+    }
+    size_t max_bytes = __atomic_load_n(&site_max_bytes, __ATOMIC_RELAXED);
+    if (__atomic_add_fetch(&site_cached_bytes, block->size, __ATOMIC_RELAXED) > max_bytes) {
+        __atomic_fetch_sub(&site_cached_bytes, block->size, __ATOMIC_RELAXED);
+        myfree(ptr);
+        return;
+    }
+
+    TRACE('f', ptr, 0);
+    tcache_register();
+    block->cached = true;
+    block->calloced = false;
+    sc->blocks[sc->count++] = block;
+    STAT_ADD(nfree, 1);
+    GAUGE_SUB(allocated, block->size);
+}
+
+/**
+ * Returns every block in a thread cache, and its deferred frees, to the
+ * free list
+ *
+ * @param tc Cache to drain, owned by the calling (or exiting) thread
+ * @return Number of bytes released
+ */
+static size_t tcache_drain(thread_cache_t *tc) {
+    size_t drained = 0, bytes = 0;
+
+    if (tc->nfree_buf > 0) {
+        bytes += free_buffer_flush(tc);
+    }
+    for (size_t c = 0; c < TCACHE_CLASSES; c++) {
+        bytes += free_blocks(tc->bins[c], tc->counts[c]);
+        drained += tc->counts[c];
+        tc->counts[c] = 0;
+    }
+    for (size_t i = 0; i < SITE_MAX; i++) {
+        drained += tc->sites[i].count;
+        bytes += site_flush(&tc->sites[i]);
+    }
+
+    STAT_ADD(tcache_drained, drained);
+    return bytes;
+}
+
+/**
+ * pthread key destructor: drains the exiting thread's cache
+ */
+static void tcache_destructor(void *arg) {
+    thread_cache_t *tc = arg;
+    tcache_drain(tc);
+    tc->registered = false;
+}
+
+/**
+ * Returns every block parked in the zero cache to the free list
+ *
+ * @return Number of bytes released
+ */
+static size_t zero_cache_flush(void) {
+    node_t *parked[ZCACHE_CLASSES * ZCACHE_DEPTH * 2];
+    size_t nparked = 0;
+
+    pthread_mutex_lock(&zero_cache_lock);
+    for (size_t c = 0; c < ZCACHE_CLASSES; c++) {
+        zero_class_t *zc = &zero_cache[c];
+        memcpy(&parked[nparked], zc->ready, zc->nready * sizeof(node_t *));
+        nparked += zc->nready;
+        memcpy(&parked[nparked], zc->pending, zc->npending * sizeof(node_t *));
+        nparked += zc->npending;
+        zc->nready = 0;
+        zc->npending = 0;
+    }
+    pthread_mutex_unlock(&zero_cache_lock);
+
+    return free_blocks(parked, nparked);
+}
+
+/**
+ * Returns fully free chunks to the kernel
+ *
+ * @return Number of bytes unmapped
+ *
+ * A free block that starts on a page boundary and ends on one covers
+ * nothing but whole heap pages, so it is unlinked and munmap'd. Arenas
+ * are trimmed one after another. At most WALK_BATCH nodes are visited
+ * per hold of the arena lock, and the spans unlinked in that hold are
+ * unmapped after the lock is dropped.
+ */
+size_t mymalloc_trim(void) {
+    size_t released = 0;
+
+    for (size_t a = 0; a < NUM_ARENAS; a++) {
+        arena_t *arena = &arenas[a];
+        pthread_mutex_lock(&arena->lock);
+        node_t *current = arena->head;
+        node_t *prev = NULL;
+
+        for (;;) {
+            node_t *spans = NULL; // unlinked, linked through next
+
+            for (size_t visited = 0; current != NULL && visited < WALK_BATCH; visited++) {
+                node_t *next = current->next;
+                size_t span = sizeof(node_t) + current->size;
+
+                if (current->free_flag && current->pins == 0 &&
+                    ((uintptr_t)current & (PAGE_SIZE - 1)) == 0 &&
+                    (span & (PAGE_SIZE - 1)) == 0) {
+                    if (prev == NULL) {
+                        arena->head = next;
+                    } else {
+                        prev->next = next;
+                    }
+                    current->next = spans;
+                    spans = current;
+                } else {
+                    prev = current;
+                }
+                current = next;
+            }
+
+            // Resume after prev, which stays listed while it is pinned
+            bool more = current != NULL;
+            if (more && prev) prev->pins++;
+            pthread_mutex_unlock(&arena->lock);
+
+            while (spans != NULL) {
+                node_t *next = spans->next;
+                size_t span = sizeof(node_t) + spans->size;
+                unmap_chunk(spans, span, arena->flags);
+                released += span;
+                spans = next;
+            }
+            if (!more) break;
+
+            pthread_mutex_lock(&arena->lock);
+            if (prev) {
+                prev->pins--;
+                current = prev->next;
+            } else {
+                current = arena->head;
+            }
+        }
+    }
+
+    return released;
+}
+
+// Free list totals gathered by heap_walk()
+typedef mymalloc_walk_t heap_walk_t;
+
+/**
+ * Walks every arena's free list to collect free space statistics
+ *
+ * @param walk Receives the totals
+ *
+ * Arenas are visited one at a time, WALK_BATCH nodes per lock hold, so an
+ * allocating thread waits at most for one batch of its own arena. The
+ * totals are therefore not an atomic snapshot of a busy heap.
+ */
+static void heap_walk(heap_walk_t *walk) {
+    memset(walk, 0, sizeof(*walk));
+
+    for (size_t a = 0; a < NUM_ARENAS; a++) {
+        arena_t *arena = &arenas[a];
+        pthread_mutex_lock(&arena->lock);
+        node_t *current = arena->head;
+
+        while (current != NULL) {
+            node_t *last = NULL;
+            for (size_t visited = 0; current != NULL && visited < WALK_BATCH; visited++) {
+                if (current->free_flag) {
+                    walk->free_bytes += current->size;
+                    walk->free_blocks++;
+                    if (current->size > walk->largest_free) walk->largest_free = current->size;
+                }
+                last = current;
+                current = current->next;
+            }
+            if (current == NULL) break;
+
+            // Let allocations in, then resume after the pinned last node
+            last->pins++;
+            pthread_mutex_unlock(&arena->lock);
+            pthread_mutex_lock(&arena->lock);
+            last->pins--;
+            current = last->next;
+        }
+        pthread_mutex_unlock(&arena->lock);
+    }
+}
+
+/**
+ * Runtime control interface
+ * Every knob is a named entry with a handler that reads the old value
+ * into *oldp and then applies *newp; either pointer may be NULL.
  */
-void *mymalloc(size_t size) {
-    // Initial input validation and size alignment
-    if (size == 0) return NULL;
+typedef struct ctl_entry {
+    const char *name;
+    int (*handler)(void *oldp, void *newp);
+} ctl_entry_t;
+
+/**
+ * Reads and optionally updates a size_t knob under a lock
+ *
+ * @return 0 on success, EINVAL if *newp is outside [min, max]
+ */
+static int ctl_size(pthread_mutex_t *lock, size_t *var, size_t min, size_t max,
+                    void *oldp, void *newp) {
+    if (newp && (*(size_t *)newp < min || *(size_t *)newp > max)) return EINVAL;
+
+    // Fast paths read knobs without the lock, hence the atomic accesses
+    pthread_mutex_lock(lock);
+    if (oldp) *(size_t *)oldp = __atomic_load_n(var, __ATOMIC_RELAXED);
+    if (newp) __atomic_store_n(var, *(size_t *)newp, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(lock);
+    return 0;
+}
+
+/**
+ * Reads and optionally updates a bool knob under a lock
+ *
+ * @return 0
+ */
+static int ctl_bool(pthread_mutex_t *lock, bool *var, void *oldp, void *newp) {
+    // Fast paths read knobs without the lock, hence the atomic accesses
+    pthread_mutex_lock(lock);
+    if (oldp) *(bool *)oldp = __atomic_load_n(var, __ATOMIC_RELAXED);
+    if (newp) __atomic_store_n(var, *(bool *)newp, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(lock);
+    return 0;
+}
+
+/**
+ * Reads a statistics counter, which cannot be written
+ */
+static int ctl_stat(size_t *counter, void *oldp, void *newp) {
+    if (newp) return EPERM;
+    if (oldp) *(size_t *)oldp = __atomic_load_n(counter, __ATOMIC_RELAXED);
+    return 0;
+}
+
+static int ctl_narenas(void *oldp, void *newp) {
+    return ctl_size(&allocator_lock, &narenas, 1, MAX_ARENAS, oldp, newp);
+}
+
+static int ctl_trace_fd(void *oldp, void *newp) {
+    if (newp && *(int *)newp < -1) return EINVAL;
 
     pthread_mutex_lock(&allocator_lock);
-    
-    // Minimum allocation size
-    size = (size < sizeof(void*)) ? sizeof(void*) : size;
-    size = (size + 7) & ~7; // Align size
+    if (oldp) *(int *)oldp = trace_fd;
+    if (newp) __atomic_store_n(&trace_fd, *(int *)newp, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&allocator_lock);
+    return 0;
+}
 
-    // Large allocation: directly map memory using mmap
-    if (size >= PAGE_SIZE) {
-        size_t total_size = size + sizeof(node_t);
-        size_t pages_needed = (total_size + PAGE_SIZE - 1) / PAGE_SIZE;
-        size_t alloc_size = pages_needed * PAGE_SIZE;
+// The calling thread's flags, as mymalloc_setflags() sets them
+static int ctl_thread_flags(void *oldp, void *newp) {
+    if (newp && (*(int *)newp & ~HEAP_FLAGS)) return EINVAL;
 
-        void *ptr = mmap(NULL, alloc_size, PROT_READ | PROT_WRITE, 
-                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-        if (ptr == MAP_FAILED) {
-            pthread_mutex_unlock(&allocator_lock);
-            return NULL;
-        }
+    if (oldp) *(int *)oldp = tcache.flags;
+    if (newp) tcache.flags = *(int *)newp;
+    return 0;
+}
 
-        // Create and configure metadata for large block
-        node_t *large_block = (node_t *)ptr;
-        large_block->size = alloc_size - sizeof(node_t);
-        large_block->free_flag = false;
-        large_block->next = NULL;
+static int ctl_mmap_threshold(void *oldp, void *newp) {
+    return ctl_size(&allocator_lock, &mmap_threshold, sizeof(void*), (size_t)-1, oldp, newp);
+}
 
-        pthread_mutex_unlock(&allocator_lock);
-        return (void *)(large_block + 1);
+static int ctl_purge_interval(void *oldp, void *newp) {
+    return ctl_size(&allocator_lock, &purge_interval, 0, (size_t)-1, oldp, newp);
+}
+
+static int ctl_zcache_capacity(void *oldp, void *newp) {
+    return ctl_size(&zero_cache_lock, &zcache_capacity, 0, ZCACHE_DEPTH, oldp, newp);
+}
+
+static int ctl_tcache_capacity(void *oldp, void *newp) {
+    return ctl_size(&allocator_lock, &tcache_capacity, 0, TCACHE_DEPTH, oldp, newp);
+}
+
+static int ctl_site_max_bytes(void *oldp, void *newp) {
+    return ctl_size(&allocator_lock, &site_max_bytes, 0, (size_t)-1, oldp, newp);
+}
+
+static int ctl_site_cached_bytes(void *oldp, void *newp) {
+    return ctl_stat(&site_cached_bytes, oldp, newp);
+}
+
+static int ctl_free_batch(void *oldp, void *newp) {
+    return ctl_size(&allocator_lock, &free_batch, 0, FREE_BUFFER_SIZE, oldp, newp);
+}
+
+static int ctl_zcache_batch(void *oldp, void *newp) {
+    return ctl_size(&zero_cache_lock, &zcache_batch, 1, ZCACHE_DEPTH, oldp, newp);
+}
+
+static int ctl_sampling_enabled(void *oldp, void *newp) {
+    return ctl_bool(&allocator_lock, &sampling_enabled, oldp, newp);
+}
+
+static int ctl_sample_interval(void *oldp, void *newp) {
+    return ctl_size(&allocator_lock, &sample_interval, 1, (size_t)-1, oldp, newp);
+}
+
+static int ctl_hot_warmup(void *oldp, void *newp) {
+    return ctl_size(&allocator_lock, &hot_warmup, 1, (size_t)-1, oldp, newp);
+}
+
+static int ctl_hot_nclasses(void *oldp, void *newp) {
+    return ctl_stat(&nhot, oldp, newp);
+}
+
+static int ctl_stats_enabled(void *oldp, void *newp) {
+    return ctl_bool(&allocator_lock, &stats_enabled, oldp, newp);
+}
+
+// Actions: *oldp (size_t) receives the bytes affected, if requested
+static int ctl_zcache_flush(void *oldp, void *newp) {
+    (void)newp;
+    size_t released = zero_cache_flush();
+    if (oldp) *(size_t *)oldp = released;
+    return 0;
+}
+
+static int ctl_tcache_flush(void *oldp, void *newp) {
+    (void)newp;
+    size_t released = tcache_drain(&tcache);
+    if (oldp) *(size_t *)oldp = released;
+    return 0;
+}
+
+// Releases the calling thread's call-site caches only
+static int ctl_site_flush(void *oldp, void *newp) {
+    (void)newp;
+    size_t released = 0;
+    for (size_t i = 0; i < SITE_MAX; i++) {
+        released += site_flush(&tcache.sites[i]);
     }
+    if (oldp) *(size_t *)oldp = released;
+    return 0;
+}
 
-    // Small allocation: search and potentially split free list blocks
-    node_t *current = head;
-    node_t *prev = NULL;
+// Fits hot classes now from the samples gathered so far
+static int ctl_hot_refit(void *oldp, void *newp) {
+    (void)newp;
+    pthread_mutex_lock(&hot_lock);
+    hot_fit_locked();
+    size_t count = nhot;
+    pthread_mutex_unlock(&hot_lock);
+    if (oldp) *(size_t *)oldp = count;
+    return 0;
+}
 
-    while (current != NULL) {
-        // Find suitable free block and potentially split it
-        if (current->free_flag && current->size >= size) {
-            // Detailed splitting logic
-            if (current->size >= size + sizeof(node_t) + 8) {
-                node_t *new_block = (node_t *)((char *)(current + 1) + size);
-                new_block->size = current->size - size - sizeof(node_t);
-                new_block->free_flag = true;
-                new_block->next = current->next;
-
-                current->size = size;
-                current->free_flag = false;
-                current->next = new_block;
+static int ctl_heap_trim(void *oldp, void *newp) {
+    (void)newp;
+    size_t released = mymalloc_trim();
+    if (oldp) *(size_t *)oldp = released;
+    return 0;
+}
 
-                // Insert new block into free list
-                if (prev == NULL) {
-                    head = new_block;
-                } else {
-                    prev->next = new_block;
-                }
-            } else {
-                current->free_flag = false;
-            }
-            pthread_mutex_unlock(&allocator_lock);
-            return (void *)(current + 1);
+static int ctl_heap_purge(void *oldp, void *newp) {
+    (void)newp;
+    size_t purged = 0;
+    for (size_t a = 0; a < NUM_ARENAS; a++) {
+        purged += purge_arena(&arenas[a]);
+    }
+    if (oldp) *(size_t *)oldp = purged;
+    return 0;
+}
+
+static int ctl_stats_nmalloc(void *oldp, void *newp) { return ctl_stat(&heap_stats.nmalloc, oldp, newp); }
+static int ctl_stats_nfree(void *oldp, void *newp) { return ctl_stat(&heap_stats.nfree, oldp, newp); }
+static int ctl_stats_allocated(void *oldp, void *newp) { return ctl_stat(&heap_stats.allocated, oldp, newp); }
+static int ctl_stats_mapped(void *oldp, void *newp) { return ctl_stat(&heap_stats.mapped, oldp, newp); }
+static int ctl_stats_nmmap(void *oldp, void *newp) { return ctl_stat(&heap_stats.nmmap, oldp, newp); }
+static int ctl_stats_search_steps(void *oldp, void *newp) { return ctl_stat(&heap_stats.search_steps, oldp, newp); }
+static int ctl_stats_coalesce_steps(void *oldp, void *newp) { return ctl_stat(&heap_stats.coalesce_steps, oldp, newp); }
+static int ctl_stats_locked_fallbacks(void *oldp, void *newp) { return ctl_stat(&heap_stats.locked_fallbacks, oldp, newp); }
+static int ctl_stats_tcache_drained(void *oldp, void *newp) { return ctl_stat(&heap_stats.tcache_drained, oldp, newp); }
+static int ctl_stats_free_batches(void *oldp, void *newp) { return ctl_stat(&heap_stats.free_batches, oldp, newp); }
+static int ctl_stats_hot_allocs(void *oldp, void *newp) { return ctl_stat(&heap_stats.hot_allocs, oldp, newp); }
+static int ctl_stats_site_hits(void *oldp, void *newp) { return ctl_stat(&heap_stats.site_hits, oldp, newp); }
+static int ctl_stats_zcache_hits(void *oldp, void *newp) { return ctl_stat(&heap_stats.zcache_hits, oldp, newp); }
+/**
+ * Reads one field of a fresh heap_walk(), which cannot be written
+ */
+static int ctl_walk(size_t offset, void *oldp, void *newp) {
+    if (newp) return EPERM;
+
+    heap_walk_t walk;
+    heap_walk(&walk);
+    if (oldp) *(size_t *)oldp = *(size_t *)((char *)&walk + offset);
+    return 0;
+}
+
+static int ctl_stats_free_bytes(void *oldp, void *newp) { return ctl_walk(offsetof(heap_walk_t, free_bytes), oldp, newp); }
+static int ctl_stats_free_blocks(void *oldp, void *newp) { return ctl_walk(offsetof(heap_walk_t, free_blocks), oldp, newp); }
+static int ctl_stats_largest_free(void *oldp, void *newp) { return ctl_walk(offsetof(heap_walk_t, largest_free), oldp, newp); }
+
+// All three free space totals from a single walk; *oldp is a mymalloc_walk_t
+static int ctl_stats_heap_walk(void *oldp, void *newp) {
+    if (newp) return EPERM;
+    if (oldp) heap_walk(oldp);
+    return 0;
+}
+static int ctl_stats_mergeable(void *oldp, void *newp) { return ctl_stat(&heap_stats.mergeable, oldp, newp); }
+static int ctl_stats_mergeable_fallbacks(void *oldp, void *newp) { return ctl_stat(&heap_stats.mergeable_fallbacks, oldp, newp); }
+
+/**
+ * Reads how many of this process's pages KSM currently shares
+ *
+ * The count comes from /proc/self/ksm_merging_pages and covers every
+ * mergeable region of the process. Kernels without the file report 0.
+ */
+static int ctl_stats_ksm_merging_pages(void *oldp, void *newp) {
+    if (newp) return EPERM;
+
+    size_t pages = 0;
+    int fd = open("/proc/self/ksm_merging_pages", O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        char buf[32];
+        ssize_t n = read(fd, buf, sizeof(buf) - 1);
+        if (n > 0) {
+            buf[n] = '\0';
+            pages = strtoul(buf, NULL, 10);
         }
-        prev = current;
-        current = current->next;
+        close(fd);
     }
+    if (oldp) *(size_t *)oldp = pages;
+    return 0;
+}
 
-    // No suitable block: allocate new page
-    size_t total_size = size + sizeof(node_t);
-    size_t alloc_size = (total_size + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+static const ctl_entry_t ctl_table[] = {
+    { "thread.flags",              ctl_thread_flags },
+    { "heap.trim",                 ctl_heap_trim },
+    { "heap.purge",                ctl_heap_purge },
+    { "opt.mmap_threshold",        ctl_mmap_threshold },
+    { "opt.purge_interval",        ctl_purge_interval },
+    { "opt.free_batch",            ctl_free_batch },
+    { "opt.narenas",               ctl_narenas },
+    { "tcache.capacity",           ctl_tcache_capacity },
+    { "tcache.flush",              ctl_tcache_flush },
+    { "zcache.capacity",           ctl_zcache_capacity },
+    { "zcache.batch",              ctl_zcache_batch },
+    { "zcache.flush",              ctl_zcache_flush },
+    { "site.max_bytes",            ctl_site_max_bytes },
+    { "site.cached_bytes",         ctl_site_cached_bytes },
+    { "site.flush",                ctl_site_flush },
+    { "opt.trace_fd",              ctl_trace_fd },
+    { "opt.sampling",              ctl_sampling_enabled },
+    { "opt.sample_interval",       ctl_sample_interval },
+    { "hot.warmup",                ctl_hot_warmup },
+    { "hot.nclasses",              ctl_hot_nclasses },
+    { "hot.refit",                 ctl_hot_refit },
+    { "stats.enabled",             ctl_stats_enabled },
+    { "stats.nmalloc",             ctl_stats_nmalloc },
+    { "stats.nfree",               ctl_stats_nfree },
+    { "stats.allocated",           ctl_stats_allocated },
+    { "stats.mapped",              ctl_stats_mapped },
+    { "stats.nmmap",               ctl_stats_nmmap },
+    { "stats.search_steps",        ctl_stats_search_steps },
+    { "stats.coalesce_steps",      ctl_stats_coalesce_steps },
+    { "stats.tcache_drained",      ctl_stats_tcache_drained },
+    { "stats.free_batches",        ctl_stats_free_batches },
+    { "stats.hot_allocs",          ctl_stats_hot_allocs },
+    { "stats.site_hits",           ctl_stats_site_hits },
+    { "stats.zcache_hits",         ctl_stats_zcache_hits },
+    { "stats.locked_fallbacks",    ctl_stats_locked_fallbacks },
+    { "stats.free_bytes",          ctl_stats_free_bytes },
+    { "stats.free_blocks",         ctl_stats_free_blocks },
+    { "stats.largest_free",        ctl_stats_largest_free },
+    { "stats.heap_walk",           ctl_stats_heap_walk },
+    { "stats.mergeable",           ctl_stats_mergeable },
+    { "stats.mergeable_fallbacks", ctl_stats_mergeable_fallbacks },
+    { "stats.ksm_merging_pages",   ctl_stats_ksm_merging_pages },
+};
+
+/**
+ * Reads and/or changes an allocator parameter by name
+ *
+ * @param name Parameter name, e.g. "opt.mmap_threshold"
+ * @param oldp If not NULL, receives the current value
+ * @param newp If not NULL, points to the new value
+ * @return 0 on success, ENOENT for an unknown name, EPERM when writing a
+ *         read-only value, EINVAL for an out-of-range value
+ *
+ * Values are size_t except "thread.flags" and "opt.trace_fd" (int),
+ * "opt.sampling" and "stats.enabled" (bool), and "stats.heap_walk"
+ * (mymalloc_walk_t, read-only). Each "stats.free_*"/"stats.largest_free"
+ * read walks the heap; "stats.heap_walk" gets all three in one walk.
+ * Actions ("heap.trim", "heap.purge", "tcache.flush", "zcache.flush",
+ * "site.flush") run on every call and report the bytes they released
+ * through oldp; "hot.refit" reports the hot class count.
+ */
+int mymalloc_ctl(const char *name, void *oldp, void *newp) {
+    if (!name) return ENOENT;
 
-    void *ptr = mmap(NULL, alloc_size, PROT_READ | PROT_WRITE, 
+    for (size_t i = 0; i < sizeof(ctl_table) / sizeof(ctl_table[0]); i++) {
+        if (strcmp(name, ctl_table[i].name) == 0) {
+            return ctl_table[i].handler(oldp, newp);
+        }
+    }
+    return ENOENT;
+}
+
+/**
+ * FIFO ring allocator
+ * Variable-size blocks are carved at the head and released from the tail.
+ * A block freed out of order is only marked free; the tail sweeps over it
+ * once every older block has been released too.
+ */
+#define RING_ALIGN 16
+
+/**
+ * Ring block metadata structure
+ * size includes the header itself so the tail can step block to block
+ */
+typedef struct ring_block {
+    size_t size;
+    size_t free_flag;
+} ring_block_t;
+
+struct myring {
+    pthread_mutex_t lock;
+    char *base;        // first byte of the block area
+    size_t capacity;   // bytes in the block area
+    size_t head;       // offset of the next allocation
+    size_t tail;       // offset of the oldest live (or pending) block
+    size_t used;       // bytes between tail and head, including wrap padding
+    size_t map_size;   // total bytes mapped for the ring
+};
+
+/**
+ * Creates a ring allocator
+ *
+ * @param capacity Number of bytes the ring can hold, headers included
+ * @return Pointer to the ring or NULL if mapping fails
+ *
+ * The ring header and block area share a single mmap'd region.
+ */
+myring_t *myring_create(size_t capacity) {
+    if (capacity == 0) return NULL;
+
+    size_t header_size = (sizeof(myring_t) + RING_ALIGN - 1) & ~(size_t)(RING_ALIGN - 1);
+    capacity = (capacity + RING_ALIGN - 1) & ~(size_t)(RING_ALIGN - 1);
+    size_t map_size = (header_size + capacity + PAGE_SIZE - 1) & ~(size_t)(PAGE_SIZE - 1);
+
+    void *ptr = mmap(NULL, map_size, PROT_READ | PROT_WRITE,
                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-    if (ptr == MAP_FAILED) {
-        pthread_mutex_unlock(&allocator_lock);
-        return NULL;
+    if (ptr == MAP_FAILED) return NULL;
+
+    myring_t *ring = (myring_t *)ptr;
+    pthread_mutex_init(&ring->lock, NULL);
+    ring->base = (char *)ptr + header_size;
+    ring->capacity = map_size - header_size; // use the rounding slack too
+    ring->head = 0;
+    ring->tail = 0;
+    ring->used = 0;
+    ring->map_size = map_size;
+    return ring;
+}
+
+/**
+ * Allocates a block at the head of the ring
+ *
+ * @param ring Ring returned by myring_create
+ * @param size Requested memory size in bytes
+ * @return Pointer to allocated memory or NULL if the ring is full
+ *
+ * - If the block does not fit before the end of the area, the remainder is
+ *   filled with a padding block (already free) and allocation wraps to 0
+ * - The ring never grows; callers fall back to mymalloc() on NULL
+ */
+void *myring_alloc(myring_t *ring, size_t size) {
+    if (!ring || size == 0) return NULL;
+    // Also keeps the rounding below from wrapping for huge sizes
+    if (size > ring->capacity - sizeof(ring_block_t)) return NULL;
+
+    size_t need = (size + sizeof(ring_block_t) + RING_ALIGN - 1) & ~(size_t)(RING_ALIGN - 1);
+    if (need > ring->capacity) return NULL;
+
+    pthread_mutex_lock(&ring->lock);
+
+    // Empty ring: restart at the beginning to maximise contiguous space
+    if (ring->used == 0) {
+        ring->head = 0;
+        ring->tail = 0;
     }
 
-    // Create new block and link to free list
-    node_t *new_block = (node_t *)ptr;
-    new_block->size = alloc_size - sizeof(node_t);
-    new_block->free_flag = false;
-    new_block->next = head;
-    head = new_block;
+    size_t offset;
+    if (ring->used != 0 && ring->head <= ring->tail) {
+        // Wrapped: free space is the gap between head and tail
+        if (ring->tail - ring->head < need) {
+            pthread_mutex_unlock(&ring->lock);
+            return NULL;
+        }
+        offset = ring->head;
+    } else if (ring->capacity - ring->head >= need) {
+        offset = ring->head;
+    } else {
+        // Not enough room before the end: pad it out and wrap
+        if (ring->tail < need) {
+            pthread_mutex_unlock(&ring->lock);
+            return NULL;
+        }
+        ring_block_t *pad = (ring_block_t *)(ring->base + ring->head);
+        pad->size = ring->capacity - ring->head;
+        pad->free_flag = true;
+        ring->used += pad->size;
+        offset = 0;
+    }
 
-    pthread_mutex_unlock(&allocator_lock);
-    return (void *)(new_block + 1);
+    ring_block_t *block = (ring_block_t *)(ring->base + offset);
+    block->size = need;
+    block->free_flag = false;
+    ring->used += need;
+    ring->head = offset + need;
+    if (ring->head == ring->capacity) ring->head = 0;
+
+    pthread_mutex_unlock(&ring->lock);
+    return (void *)(block + 1);
 }
 
 /**
- * Frees previously allocated memory
- * 
- * @param ptr Pointer to memory block to be freed
- * 
- * - For small blocks: 
- *   1. Mark block as free
- *   2. Coalesce adjacent free blocks
- * - For large blocks:
- *   1. Unmap memory using munmap
+ * Releases a ring block
+ *
+ * @param ring Ring the block was allocated from
+ * @param ptr Pointer returned by myring_alloc
+ *
+ * - Marks the block free
+ * - Advances the tail over every consecutive free block, so out-of-order
+ *   frees are reclaimed as soon as the blocks ahead of them are released
  */
-void myfree(void *ptr) {
-    if (!ptr) return;
+void myring_free(myring_t *ring, void *ptr) {
+    if (!ring || !ptr) return;
 
-    pthread_mutex_lock(&allocator_lock);
-    node_t *block_to_free = (node_t *)ptr - 1;
-    
-    // Validate block before freeing
-    if (block_to_free->free_flag) {
+    pthread_mutex_lock(&ring->lock);
+    ring_block_t *block = (ring_block_t *)ptr - 1;
+
+    if (block->free_flag) {
         printf("Double free detected!\n");
-        pthread_mutex_unlock(&allocator_lock);
+        pthread_mutex_unlock(&ring->lock);
         return;
     }
+    block->free_flag = true;
 
-    // Large allocation handling remains the same
-    if (block_to_free->size >= PAGE_SIZE) {
-        munmap(block_to_free, block_to_free->size + sizeof(node_t));
-        pthread_mutex_unlock(&allocator_lock);
-        return;
+    while (ring->used != 0) {
+        ring_block_t *oldest = (ring_block_t *)(ring->base + ring->tail);
+        if (!oldest->free_flag) break;
+
+        ring->used -= oldest->size;
+        ring->tail += oldest->size;
+        if (ring->tail == ring->capacity) ring->tail = 0;
     }
 
-    block_to_free->free_flag = true;
+    pthread_mutex_unlock(&ring->lock);
+}
 
-    // More robust coalescing
-    node_t *current = head;
-    node_t *prev = NULL;
+/**
+ * Destroys a ring allocator and unmaps its memory
+ *
+ * @param ring Ring returned by myring_create
+ */
+void myring_destroy(myring_t *ring) {
+    if (!ring) return;
+    pthread_mutex_destroy(&ring->lock);
+    munmap(ring, ring->map_size);
+}
 
-    while (current != NULL) {
-        // Advanced coalescing logic
-        if (current->free_flag) {
-            // Check if current can merge with next block
-            if (current->next && 
-                current->next->free_flag && 
-                (char*)current + sizeof(node_t) + current->size == (char*)current->next) {
-                
-                current->size += sizeof(node_t) + current->next->size;
-                current->next = current->next->next;
-                continue;  // Restart check
-            }
+/**
+ * Creates a double-mapped ("magic") ring buffer
+ *
+ * @param size Ring size in bytes, must be a multiple of PAGE_SIZE
+ * @return Base address of the ring or NULL on failure
+ *
+ * - One memfd of 'size' bytes is mapped twice back to back, so
+ *   base[i] and base[i + size] are the same byte
+ * - Reads and writes that cross the wrap point can use plain memcpy
+ *   from (base + offset) for up to 'size' bytes, no split copy needed
+ */
+void *mymagic_ring_create(size_t size) {
+    if (size == 0 || (size & (PAGE_SIZE - 1)) != 0) return NULL;
 
-            // Check if previous block can merge with current
-            if (prev && prev->free_flag && 
-                (char*)prev + sizeof(node_t) + prev->size == (char*)current) {
-                
-                prev->size += sizeof(node_t) + current->size;
-                prev->next = current->next;
-                current = prev;
-                continue;
-            }
-        }
+    int fd = memfd_create("mymagic_ring", MFD_CLOEXEC);
+    if (fd < 0) return NULL;
+    if (ftruncate(fd, size) != 0) {
+        close(fd);
+        return NULL;
+    }
 
-        prev = current;
-        current = current->next;
+    // Reserve both halves first so nothing else can land in between
+    char *base = mmap(NULL, 2 * size, PROT_NONE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        return NULL;
     }
 
-    pthread_mutex_unlock(&allocator_lock);
+    void *first = mmap(base, size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_FIXED, fd, 0);
+    void *second = mmap(base + size, size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_FIXED, fd, 0);
+    close(fd); // mappings keep the memory alive
+
+    if (first == MAP_FAILED || second == MAP_FAILED) {
+        munmap(base, 2 * size);
+        return NULL;
+    }
+    return base;
 }
 
 /**
- * Allocates and initializes memory to zero
- * 
- * @param nmemb Number of elements
- * @param s Size of each element
- * @return Pointer to zeroed memory block
+ * Destroys a ring created by mymagic_ring_create
+ *
+ * @param base Address returned by mymagic_ring_create
+ * @param size Size passed to mymagic_ring_create
  */
-void *mycalloc(size_t nmemb, size_t s) {
-    size_t total_size = nmemb * s; // Calculate total memory size needed by multiplying number of elements and element size
-    void *p = mymalloc(total_size); // Allocate memory
-    if (!p) return NULL;
-    memset(p, 0, total_size);// Initialize allocated memory to zero using memset
-    return p;
+void mymagic_ring_destroy(void *base, size_t size) {
+    if (!base) return;
+    munmap(base, 2 * size);
 }
 
+// The demo below is left out when the allocator is linked into tools
+#ifndef MYMALLOC_NO_MAIN
+
 // Simple thread function to test allocator
 void* thread_allocate(void* arg) {
     int thread_id = *(int*)arg;
@@ -256,6 +2053,14 @@ void* thread_allocate(void* arg) {
     return NULL;
 }
 
+// Allocates a small block from a thread without allocation flags
+void* thread_unflagged(void* arg) {
+    node_t *block = (node_t *)mymalloc(200) - 1;
+    *(bool *)arg = arenas[block->arena].flags == 0;
+    myfree(block + 1);
+    return NULL;
+}
+
 //main function to run program and test
 int main() {
     // Basic allocation tests
@@ -277,6 +2082,24 @@ int main() {
     pthread_t threads[NUM_THREADS];
     int thread_ids[NUM_THREADS];
 
+    // Zero cache test: with default settings, a calloc/free loop is served
+    // blocks that were zeroed when they were freed
+    printf("\nPre-zeroed Calloc Test:\n");
+    size_t zhits_before, zhits_after;
+    bool all_zero = true;
+    mymalloc_ctl("stats.zcache_hits", &zhits_before, NULL);
+    for (int i = 0; i < 100; i++) {
+        char *zeroed = mycalloc(8, 8);
+        for (int j = 0; j < 64; j++) {
+            if (zeroed[j] != 0) all_zero = false;
+        }
+        memset(zeroed, 0xAB, 64); // dirty it for the next round
+        myfree(zeroed);
+    }
+    mymalloc_ctl("stats.zcache_hits", &zhits_after, NULL);
+    printf("%zu of 100 callocs served by the zero cache, all %s\n",
+           zhits_after - zhits_before, all_zero ? "zeroed" : "NOT zeroed");
+
     printf("\nMulti-threaded Allocation Test:\n");
     for (int i = 0; i < NUM_THREADS; i++) {
         thread_ids[i] = i;
@@ -286,7 +2109,160 @@ int main() {
     for (int i = 0; i < NUM_THREADS; i++) {
         pthread_join(threads[i], NULL);
     }
+    size_t drained = 0;
+    mymalloc_ctl("stats.tcache_drained", &drained, NULL);
+    printf("Exited threads returned %zu cached block(s) to the free list\n", drained);
+
+    // FIFO ring test: out-of-order frees are deferred until the tail reaches them
+    printf("\nRing Allocator Test:\n");
+    myring_t *ring = myring_create(3 * 1024);
+    void *msgs[3];
+    for (int i = 0; i < 3; i++) {
+        msgs[i] = myring_alloc(ring, 1000);
+    }
+    myring_free(ring, msgs[1]);
+    myring_free(ring, msgs[0]);
+    void *wrapped = myring_alloc(ring, 1500);
+    printf("Wrapped ring block %s\n", wrapped == ring->base + sizeof(ring_block_t) ? "reused the front" : "misplaced");
+    myring_free(ring, msgs[2]);
+    myring_free(ring, wrapped);
+    myring_destroy(ring);
+
+    // Magic ring test: a write across the wrap point reads back contiguously
+    printf("\nMagic Ring Test:\n");
+    char *magic = mymagic_ring_create(PAGE_SIZE);
+    if (magic) {
+        memcpy(magic + PAGE_SIZE - 4, "wrapped!", 9);
+        printf("Magic ring start reads: %.5s\n", magic);
+        mymagic_ring_destroy(magic, PAGE_SIZE);
+    } else {
+        printf("Magic ring unavailable\n");
+    }
+
+    // Locked heap test: new chunks are pre-faulted and mlock'd when allowed
+    printf("\nLocked Heap Test:\n");
+    myfree(mymalloc(200)); // leaves an unlocked 200-byte block in the thread cache
+    int old_flags = mymalloc_setflags(MYMALLOC_LOCKED);
+    char *locked_ptr = mymalloc(PAGE_SIZE * 2);
+    char *locked_small = mymalloc(200);
+    size_t fallbacks = 0;
+    mymalloc_ctl("stats.locked_fallbacks", &fallbacks, NULL);
+    printf("Locked allocation %s (%zu chunk(s) fell back to unlocked)\n",
+           locked_ptr ? "succeeded" : "failed", fallbacks);
+    printf("Small locked block %s from the locked arena\n",
+           arenas[((node_t *)locked_small - 1)->arena].flags & MYMALLOC_LOCKED ? "served" : "NOT served");
+    // The flags belong to this thread; others keep their own arenas
+    pthread_t other;
+    bool other_unflagged = false;
+    pthread_create(&other, NULL, thread_unflagged, &other_unflagged);
+    pthread_join(other, NULL);
+    printf("Another thread %s\n", other_unflagged ? "kept its unlocked arena" : "was forced into the locked arena");
+    myfree(locked_ptr);
+    myfree(locked_small);
+    mymalloc_setflags(old_flags);
+
+    // Mergeable heap test: identical pages become candidates for KSM
+    printf("\nMergeable Heap Test:\n");
+    old_flags = mymalloc_setflags(MYMALLOC_MERGEABLE);
+    char *table = mymalloc(PAGE_SIZE * 4);
+    memset(table, 0x5A, PAGE_SIZE * 4);
+    size_t mergeable = 0, ksm_pages = 0;
+    mymalloc_ctl("stats.mergeable", &mergeable, NULL);
+    mymalloc_ctl("stats.ksm_merging_pages", &ksm_pages, NULL);
+    printf("%zu bytes mapped mergeable, %zu page(s) currently shared\n", mergeable, ksm_pages);
+    myfree(table);
+    mymalloc_ctl("stats.mergeable", &mergeable, NULL);
+    printf("%zu mergeable bytes left after freeing the table\n", mergeable);
+    mymalloc_setflags(old_flags);
+
+    // Batched free test: large frees are released in one locked pass
+    printf("\nBatched Free Test:\n");
+    size_t batch = 4, old_batch, batches_before, batches_after;
+    mymalloc_ctl("opt.free_batch", &old_batch, &batch);
+    mymalloc_ctl("stats.free_batches", &batches_before, NULL);
+    for (int i = 0; i < 8; i++) {
+        myfree(mymalloc(512));
+    }
+    mymalloc_ctl("stats.free_batches", &batches_after, NULL);
+    printf("8 frees took %zu locked pass(es)\n", batches_after - batches_before);
+    mymalloc_ctl("opt.free_batch", NULL, &old_batch);
+    mymalloc_ctl("tcache.flush", NULL, NULL);
+
+    // Hot size class test: a dominant 72-byte struct gets its own class
+    printf("\nHot Size Class Test:\n");
+    bool sampling = true;
+    size_t interval = 1, warmup = 64, nclasses = 0, hot_before, hot_after;
+    mymalloc_ctl("opt.sample_interval", NULL, &interval);
+    mymalloc_ctl("hot.warmup", NULL, &warmup);
+    mymalloc_ctl("opt.sampling", NULL, &sampling);
+    for (int i = 0; i < 64; i++) {
+        myfree(mymalloc(72));
+    }
+    mymalloc_ctl("hot.nclasses", &nclasses, NULL);
+    mymalloc_ctl("stats.hot_allocs", &hot_before, NULL);
+    void *structs[32];
+    for (int i = 0; i < 32; i++) {
+        structs[i] = mymalloc(72);
+    }
+    mymalloc_ctl("stats.hot_allocs", &hot_after, NULL);
+    printf("%zu hot class(es), %zu of 32 structs served exact-size\n",
+           nclasses, hot_after - hot_before);
+    for (int i = 0; i < 32; i++) {
+        myfree(structs[i]);
+    }
+    // Slabs are unmapped again once a burst is freed
+    static void *burst[2000];
+    size_t slabs_before, slabs_peak, slabs_after;
+    mymalloc_ctl("stats.mapped", &slabs_before, NULL);
+    for (int i = 0; i < 2000; i++) {
+        burst[i] = mymalloc(72);
+    }
+    mymalloc_ctl("stats.mapped", &slabs_peak, NULL);
+    for (int i = 0; i < 2000; i++) {
+        myfree(burst[i]);
+    }
+    mymalloc_ctl("stats.mapped", &slabs_after, NULL);
+    printf("A burst of 2000 structs mapped %zu bytes, %zu still mapped after freeing\n",
+           slabs_peak - slabs_before, slabs_after - slabs_before);
+    sampling = false;
+    mymalloc_ctl("opt.sampling", NULL, &sampling);
+
+    // Call-site cache test: a loop that allocates and frees the same 600-byte buffer
+    printf("\nCall-Site Cache Test:\n");
+    size_t site_before, site_after, site_released;
+    mymalloc_ctl("stats.site_hits", &site_before, NULL);
+    for (int i = 0; i < 100; i++) {
+        char *buf = mymalloc_site(3, 600);
+        memset(buf, i, 600);
+        myfree_site(3, buf);
+    }
+    mymalloc_ctl("stats.site_hits", &site_after, NULL);
+    mymalloc_ctl("site.flush", &site_released, NULL);
+    printf("%zu of 100 allocations recycled by the site, flush released %zu bytes\n",
+           site_after - site_before, site_released);
+
+    // Control interface test: tune a knob live and read statistics back
+    printf("\nControl Interface Test:\n");
+    size_t old_threshold, new_threshold = 1024, mapped_before, mapped_after, released;
+    mymalloc_ctl("opt.mmap_threshold", &old_threshold, &new_threshold);
+    mymalloc_ctl("stats.mapped", &mapped_before, NULL);
+    char *mid_ptr = mymalloc(2000); // now above the threshold: own mapping
+    mymalloc_ctl("stats.mapped", &mapped_after, NULL);
+    printf("2000-byte block mapped %zu new bytes\n", mapped_after - mapped_before);
+    myfree(mid_ptr);
+    mymalloc_ctl("opt.mmap_threshold", NULL, &old_threshold);
+    mymalloc_ctl("tcache.flush", NULL, NULL);
+    mymalloc_ctl("zcache.flush", NULL, NULL);
+    mymalloc_ctl("heap.trim", &released, NULL);
+    printf("Trim released %zu bytes, unknown key returns %s\n", released,
+           mymalloc_ctl("no.such.key", NULL, NULL) == ENOENT ? "ENOENT" : "?");
+    mymalloc_walk_t walk;
+    mymalloc_ctl("stats.heap_walk", &walk, NULL);
+    printf("After trim: %zu free bytes in %zu block(s), largest %zu\n",
+           walk.free_bytes, walk.free_blocks, walk.largest_free);
 
     printf("All tests completed successfully\n");
     return 0;
-}
\ No newline at end of file
+}
+
+#endif /* ifndef MYMALLOC_NO_MAIN */
@@ -0,0 +1,676 @@
+/**
+ * Offline allocator policy simulator.
+ * Replays an allocation trace (as recorded through mymalloc_ctl's
+ * "opt.trace_fd") against a model of mymalloc's free list placement:
+ * - Only addresses, block sizes and free flags are modelled; no memory
+ *   is ever touched, so weeks of traces replay in minutes
+ * - Chunks are "mapped" top-down and adjacent, like Linux mmap, so
+ *   blocks from neighbouring chunks coalesce as they do for real
+ * - The list is never walked. Blocks sit in a balanced tree in list
+ *   order that knows each subtree's largest free block, so a fit is
+ *   found in O(log n). mymalloc's search steps are read off as the fit's
+ *   list position, and its full-list coalescing pass is charged as the
+ *   list length; merges are done with the block's neighbours only
+ * - One arena is modelled; thread, zero and hot class caches are not
+ *
+ * Usage: simulate [-p first|best|next] [-a align] [-t mmap_threshold] trace
+ * Without -p every policy is run and reported on its own line.
+ */
+
+// importing neccesary libararies
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+#define PAGE_SIZE 4096  // system page size
+#define HEADER_SIZE 24  // sizeof(node_t) in mymalloc.c
+#define MIN_SPLIT 8     // smallest remainder worth a split, as in mymalloc.c
+#define NIL ((size_t)-1)
+
+typedef enum { FIRST_FIT, BEST_FIT, NEXT_FIT, NUM_POLICIES } policy_t;
+
+static const char *policy_names[NUM_POLICIES] = { "first", "best", "next" };
+
+/**
+ * Trace operation
+ * Pointers from the trace are only used as identities.
+ */
+typedef struct trace_op {
+    char op;          // 'm', 'c' or 'f'
+    uint64_t id;      // pointer value from the trace
+    size_t size;      // requested bytes ('m' and 'c' only)
+} trace_op_t;
+
+/**
+ * Simulated block, a node of two treaps
+ * The list treap holds every listed block, ordered by free list position
+ * (an implicit key: a node's position is the size of everything left of
+ * it). The size treap holds the free blocks ordered by size, then list
+ * position, for best fit.
+ */
+typedef struct sim_block {
+    uint64_t addr;    // simulated header address
+    size_t size;      // payload bytes
+    bool free_flag;
+    bool mmapped;     // dedicated mapping, not on the list
+    uint32_t prio;    // heap priority in both treaps
+    size_t left, right, parent; // list treap links
+    size_t count;     // blocks in the list subtree
+    size_t max_free;  // largest free block in the list subtree, 0 if none
+    size_t sleft, sright;       // size treap links
+    size_t next;      // next spare slot, while recycled
+} sim_block_t;
+
+/**
+ * Live pointer table: trace id -> block index, open addressing
+ */
+typedef struct live_map {
+    uint64_t *keys;   // 0 marks an empty slot
+    size_t *values;
+    size_t capacity;  // power of two
+    size_t count;
+} live_map_t;
+
+/**
+ * Simulator state for one policy run
+ */
+typedef struct sim {
+    policy_t policy;
+    size_t align;
+    size_t mmap_threshold;
+
+    sim_block_t *blocks;
+    size_t nblocks, capacity;
+    size_t spare;        // recycled block slots, linked through next
+    size_t root;         // list treap
+    size_t size_root;    // size treap of free blocks
+    size_t rover;        // next-fit resume point
+    uint32_t seed;       // treap priority generator
+    uint64_t map_top;    // chunks are placed just below this address
+
+    live_map_t live;
+
+    // results
+    size_t mapped, peak_mapped;
+    size_t live_bytes, live_at_peak, peak_live;
+    size_t search_steps, coalesce_steps;
+    size_t nmalloc, nfree, nmmap;
+} sim_t;
+
+static void *xrealloc(void *ptr, size_t size) {
+    void *p = realloc(ptr, size);
+    if (!p) {
+        fprintf(stderr, "simulate: out of memory\n");
+        exit(1);
+    }
+    return p;
+}
+
+static size_t hash_id(uint64_t id, size_t capacity) {
+    return (size_t)((id >> 3) * 0x9E3779B97F4A7C15ull) & (capacity - 1);
+}
+
+static void live_put(live_map_t *map, uint64_t id, size_t value);
+
+static void live_grow(live_map_t *map) {
+    live_map_t old = *map;
+    map->capacity = old.capacity ? old.capacity * 2 : 1024;
+    map->keys = calloc(map->capacity, sizeof(uint64_t));
+    map->values = calloc(map->capacity, sizeof(size_t));
+    map->count = 0;
+    if (!map->keys || !map->values) {
+        fprintf(stderr, "simulate: out of memory\n");
+        exit(1);
+    }
+    for (size_t i = 0; i < old.capacity; i++) {
+        if (old.keys[i]) live_put(map, old.keys[i], old.values[i]);
+    }
+    free(old.keys);
+    free(old.values);
+}
+
+static void live_put(live_map_t *map, uint64_t id, size_t value) {
+    if ((map->count + 1) * 2 > map->capacity) live_grow(map);
+    size_t i = hash_id(id, map->capacity);
+    while (map->keys[i] && map->keys[i] != id) i = (i + 1) & (map->capacity - 1);
+    if (!map->keys[i]) map->count++;
+    map->keys[i] = id;
+    map->values[i] = value;
+}
+
+/**
+ * Removes an id from the table
+ *
+ * @return The block index, or NIL if the id is not live
+ */
+static size_t live_take(live_map_t *map, uint64_t id) {
+    if (map->capacity == 0) return NIL;
+    size_t i = hash_id(id, map->capacity);
+    while (map->keys[i] && map->keys[i] != id) i = (i + 1) & (map->capacity - 1);
+    if (!map->keys[i]) return NIL;
+
+    size_t value = map->values[i];
+    map->keys[i] = 0;
+    map->count--;
+    // Re-insert the rest of the cluster so lookups never stop early
+    for (size_t j = (i + 1) & (map->capacity - 1); map->keys[j]; j = (j + 1) & (map->capacity - 1)) {
+        uint64_t key = map->keys[j];
+        size_t moved = map->values[j];
+        map->keys[j] = 0;
+        map->count--;
+        live_put(map, key, moved);
+    }
+    return value;
+}
+
+static size_t block_new(sim_t *sim) {
+    if (sim->spare != NIL) {
+        size_t b = sim->spare;
+        sim->spare = sim->blocks[b].next;
+        return b;
+    }
+    if (sim->nblocks == sim->capacity) {
+        sim->capacity = sim->capacity ? sim->capacity * 2 : 1024;
+        sim->blocks = xrealloc(sim->blocks, sim->capacity * sizeof(sim_block_t));
+    }
+    return sim->nblocks++;
+}
+
+static void block_release(sim_t *sim, size_t b) {
+    sim->blocks[b].next = sim->spare;
+    sim->spare = b;
+}
+
+static size_t tree_count(const sim_t *sim, size_t t) {
+    return t == NIL ? 0 : sim->blocks[t].count;
+}
+
+static size_t tree_max_free(const sim_t *sim, size_t t) {
+    return t == NIL ? 0 : sim->blocks[t].max_free;
+}
+
+// Recomputes t's subtree totals and re-parents its children
+static void tree_pull(sim_t *sim, size_t t) {
+    sim_block_t *n = &sim->blocks[t];
+    size_t own = n->free_flag ? n->size : 0;
+    size_t l = tree_max_free(sim, n->left), r = tree_max_free(sim, n->right);
+
+    n->count = 1 + tree_count(sim, n->left) + tree_count(sim, n->right);
+    n->max_free = own > l ? own : l;
+    if (r > n->max_free) n->max_free = r;
+    if (n->left != NIL) sim->blocks[n->left].parent = t;
+    if (n->right != NIL) sim->blocks[n->right].parent = t;
+}
+
+// Concatenates two list treaps
+static size_t tree_merge(sim_t *sim, size_t a, size_t b) {
+    if (a == NIL) return b;
+    if (b == NIL) return a;
+    if (sim->blocks[a].prio > sim->blocks[b].prio) {
+        sim->blocks[a].right = tree_merge(sim, sim->blocks[a].right, b);
+        tree_pull(sim, a);
+        return a;
+    }
+    sim->blocks[b].left = tree_merge(sim, a, sim->blocks[b].left);
+    tree_pull(sim, b);
+    return b;
+}
+
+// Splits a list treap into its first k blocks and the rest
+static void tree_split(sim_t *sim, size_t t, size_t k, size_t *first, size_t *rest) {
+    if (t == NIL) {
+        *first = *rest = NIL;
+        return;
+    }
+    size_t left = tree_count(sim, sim->blocks[t].left);
+    if (left < k) {
+        size_t right;
+        tree_split(sim, sim->blocks[t].right, k - left - 1, &right, rest);
+        sim->blocks[t].right = right;
+        tree_pull(sim, t);
+        *first = t;
+    } else {
+        size_t l;
+        tree_split(sim, sim->blocks[t].left, k, first, &l);
+        sim->blocks[t].left = l;
+        tree_pull(sim, t);
+        *rest = t;
+    }
+}
+
+static void tree_set_root(sim_t *sim, size_t root) {
+    sim->root = root;
+    if (root != NIL) sim->blocks[root].parent = NIL;
+}
+
+// List position of a listed block: the search steps mymalloc takes to reach it, minus one
+static size_t list_pos(const sim_t *sim, size_t b) {
+    size_t pos = tree_count(sim, sim->blocks[b].left);
+    for (size_t t = b; sim->blocks[t].parent != NIL; t = sim->blocks[t].parent) {
+        size_t p = sim->blocks[t].parent;
+        if (sim->blocks[p].right == t) pos += tree_count(sim, sim->blocks[p].left) + 1;
+    }
+    return pos;
+}
+
+// Block at a list position, or NIL past the end
+static size_t list_at(const sim_t *sim, size_t pos) {
+    size_t t = sim->root;
+    while (t != NIL) {
+        size_t left = tree_count(sim, sim->blocks[t].left);
+        if (pos < left) {
+            t = sim->blocks[t].left;
+        } else if (pos == left) {
+            return t;
+        } else {
+            pos -= left + 1;
+            t = sim->blocks[t].right;
+        }
+    }
+    return NIL;
+}
+
+static size_t list_next(const sim_t *sim, size_t b) {
+    return list_at(sim, list_pos(sim, b) + 1);
+}
+
+static size_t list_prev(const sim_t *sim, size_t b) {
+    size_t pos = list_pos(sim, b);
+    return pos == 0 ? NIL : list_at(sim, pos - 1);
+}
+
+// Refreshes the totals above b after its size or free flag changed
+static void list_update(sim_t *sim, size_t b) {
+    for (size_t t = b; t != NIL; t = sim->blocks[t].parent) {
+        tree_pull(sim, t);
+    }
+}
+
+// Inserts block b after block 'after' (NIL: at the head of the list)
+static void list_insert(sim_t *sim, size_t b, size_t after) {
+    size_t pos = (after == NIL) ? 0 : list_pos(sim, after) + 1;
+    size_t first, rest;
+
+    sim->seed ^= sim->seed << 13;
+    sim->seed ^= sim->seed >> 17;
+    sim->seed ^= sim->seed << 5;
+    sim->blocks[b].prio = sim->seed;
+    sim->blocks[b].left = sim->blocks[b].right = NIL;
+    tree_pull(sim, b);
+
+    tree_split(sim, sim->root, pos, &first, &rest);
+    tree_set_root(sim, tree_merge(sim, tree_merge(sim, first, b), rest));
+}
+
+static void list_remove(sim_t *sim, size_t b) {
+    if (sim->rover == b) sim->rover = list_next(sim, b);
+
+    size_t first, middle, rest;
+    tree_split(sim, sim->root, list_pos(sim, b), &first, &middle);
+    tree_split(sim, middle, 1, &middle, &rest);
+    tree_set_root(sim, tree_merge(sim, first, rest));
+}
+
+/**
+ * First free block of at least 'size' bytes at list position 'from' or
+ * later, within subtree t (positions relative to t)
+ */
+static size_t first_fit(const sim_t *sim, size_t t, size_t from, size_t size) {
+    if (t == NIL || tree_max_free(sim, t) < size) return NIL;
+
+    const sim_block_t *n = &sim->blocks[t];
+    size_t left = tree_count(sim, n->left);
+    if (from < left) {
+        size_t b = first_fit(sim, n->left, from, size);
+        if (b != NIL) return b;
+    }
+    if (from <= left && n->free_flag && n->size >= size) return t;
+    return first_fit(sim, n->right, from > left ? from - left - 1 : 0, size);
+}
+
+// Orders free blocks by size, then by list position
+static bool size_less(const sim_t *sim, size_t a, size_t b) {
+    if (sim->blocks[a].size != sim->blocks[b].size) return sim->blocks[a].size < sim->blocks[b].size;
+    return list_pos(sim, a) < list_pos(sim, b);
+}
+
+static size_t size_merge(sim_t *sim, size_t a, size_t b) {
+    if (a == NIL) return b;
+    if (b == NIL) return a;
+    if (sim->blocks[a].prio > sim->blocks[b].prio) {
+        sim->blocks[a].sright = size_merge(sim, sim->blocks[a].sright, b);
+        return a;
+    }
+    sim->blocks[b].sleft = size_merge(sim, a, sim->blocks[b].sleft);
+    return b;
+}
+
+// Splits the size treap into the blocks ordered before b and the rest
+static void size_split(sim_t *sim, size_t t, size_t b, size_t *before, size_t *rest) {
+    if (t == NIL) {
+        *before = *rest = NIL;
+        return;
+    }
+    if (size_less(sim, t, b)) {
+        size_t right;
+        size_split(sim, sim->blocks[t].sright, b, &right, rest);
+        sim->blocks[t].sright = right;
+        *before = t;
+    } else {
+        size_t left;
+        size_split(sim, sim->blocks[t].sleft, b, before, &left);
+        sim->blocks[t].sleft = left;
+        *rest = t;
+    }
+}
+
+// Adds a free listed block; its size and list position must be final
+static void size_insert(sim_t *sim, size_t b) {
+    size_t before, rest;
+    sim->blocks[b].sleft = sim->blocks[b].sright = NIL;
+    size_split(sim, sim->size_root, b, &before, &rest);
+    sim->size_root = size_merge(sim, size_merge(sim, before, b), rest);
+}
+
+static size_t size_drop_first(sim_t *sim, size_t t) {
+    if (sim->blocks[t].sleft == NIL) return sim->blocks[t].sright;
+    sim->blocks[t].sleft = size_drop_first(sim, sim->blocks[t].sleft);
+    return t;
+}
+
+// Removes a free block while its size and list position are unchanged
+static void size_remove(sim_t *sim, size_t b) {
+    size_t before, rest;
+    size_split(sim, sim->size_root, b, &before, &rest);
+    sim->size_root = size_merge(sim, before, size_drop_first(sim, rest));
+}
+
+static uint64_t map_pages(sim_t *sim, size_t size) {
+    sim->map_top -= size;
+    sim->mapped += size;
+    sim->nmmap++;
+    return sim->map_top;
+}
+
+// Splits block b to 'size' bytes if the rest is worth keeping, as mymalloc does
+static void split(sim_t *sim, size_t b, size_t size) {
+    if (sim->blocks[b].size < size + HEADER_SIZE + MIN_SPLIT) return;
+
+    size_t rest = block_new(sim);
+    sim_block_t *blk = &sim->blocks[b];
+    sim->blocks[rest] = (sim_block_t){
+        .addr = blk->addr + HEADER_SIZE + size,
+        .size = blk->size - size - HEADER_SIZE,
+        .free_flag = true,
+    };
+    blk->size = size;
+    list_insert(sim, rest, b);
+    size_insert(sim, rest);
+}
+
+/**
+ * Finds a free block of at least 'size' bytes under the current policy
+ *
+ * @return Block index or NIL; the blocks mymalloc's walk would visit are
+ *         added to search_steps
+ */
+static size_t find_fit(sim_t *sim, size_t size) {
+    size_t len = tree_count(sim, sim->root);
+    size_t b;
+
+    switch (sim->policy) {
+    case FIRST_FIT:
+        b = first_fit(sim, sim->root, 0, size);
+        sim->search_steps += (b == NIL) ? len : list_pos(sim, b) + 1;
+        return b;
+
+    case BEST_FIT: {
+        // Smallest fitting size, earliest on the list among equals
+        b = NIL;
+        for (size_t t = sim->size_root; t != NIL; ) {
+            if (sim->blocks[t].size >= size) {
+                b = t;
+                t = sim->blocks[t].sleft;
+            } else {
+                t = sim->blocks[t].sright;
+            }
+        }
+        // The walk stops early only on an exact fit
+        sim->search_steps += (b != NIL && sim->blocks[b].size == size) ? list_pos(sim, b) + 1 : len;
+        return b;
+    }
+
+    case NEXT_FIT: {
+        size_t start = (sim->rover != NIL) ? list_pos(sim, sim->rover) : 0;
+        b = first_fit(sim, sim->root, start, size);
+        if (b != NIL) {
+            sim->search_steps += list_pos(sim, b) - start + 1;
+        } else {
+            // Wrap around to the head
+            b = first_fit(sim, sim->root, 0, size);
+            sim->search_steps += (b == NIL) ? len : len - start + list_pos(sim, b) + 1;
+        }
+        if (b != NIL) sim->rover = list_next(sim, b);
+        return b;
+    }
+
+    default:
+        return NIL;
+    }
+}
+
+static void sim_malloc(sim_t *sim, uint64_t id, size_t request) {
+    if (request == 0 || id == 0) return;
+
+    size_t size = (request < sizeof(void*)) ? sizeof(void*) : request;
+    size = (size + sim->align - 1) & ~(sim->align - 1);
+    size_t b;
+
+    if (size >= sim->mmap_threshold) {
+        size_t alloc_size = (size + HEADER_SIZE + PAGE_SIZE - 1) & ~(size_t)(PAGE_SIZE - 1);
+        b = block_new(sim);
+        sim->blocks[b] = (sim_block_t){
+            .addr = map_pages(sim, alloc_size),
+            .size = alloc_size - HEADER_SIZE,
+            .mmapped = true,
+        };
+    } else {
+        b = find_fit(sim, size);
+        if (b == NIL) {
+            size_t alloc_size = (size + HEADER_SIZE + PAGE_SIZE - 1) & ~(size_t)(PAGE_SIZE - 1);
+            b = block_new(sim);
+            sim->blocks[b] = (sim_block_t){
+                .addr = map_pages(sim, alloc_size),
+                .size = alloc_size - HEADER_SIZE,
+            };
+            list_insert(sim, b, NIL);
+        } else {
+            size_remove(sim, b);
+            sim->blocks[b].free_flag = false;
+            // The block's own free size leaves its ancestors' maxima
+            list_update(sim, b);
+        }
+        split(sim, b, size);
+    }
+
+    sim->nmalloc++;
+    sim->live_bytes += request;
+    if (sim->live_bytes > sim->peak_live) sim->peak_live = sim->live_bytes;
+    if (sim->mapped > sim->peak_mapped) {
+        sim->peak_mapped = sim->mapped;
+        sim->live_at_peak = sim->live_bytes;
+    }
+    live_put(&sim->live, id, b);
+}
+
+static void sim_free(sim_t *sim, uint64_t id, size_t request) {
+    size_t b = live_take(&sim->live, id);
+    if (b == NIL) return; // freed before the trace started, or bogus
+    sim->nfree++;
+    sim->live_bytes -= request;
+
+    sim_block_t *blk = &sim->blocks[b];
+    if (blk->mmapped) {
+        sim->mapped -= blk->size + HEADER_SIZE;
+        block_release(sim, b);
+        return;
+    }
+
+    // mymalloc walks the whole list on every free; charge that cost
+    sim->coalesce_steps += tree_count(sim, sim->root);
+    blk->free_flag = true;
+
+    size_t next = list_next(sim, b);
+    if (next != NIL && sim->blocks[next].free_flag &&
+        blk->addr + HEADER_SIZE + blk->size == sim->blocks[next].addr) {
+        size_remove(sim, next);
+        blk->size += HEADER_SIZE + sim->blocks[next].size;
+        list_remove(sim, next);
+        block_release(sim, next);
+    }
+    size_t prev = list_prev(sim, b);
+    if (prev != NIL && sim->blocks[prev].free_flag &&
+        sim->blocks[prev].addr + HEADER_SIZE + sim->blocks[prev].size == blk->addr) {
+        size_remove(sim, prev);
+        sim->blocks[prev].size += HEADER_SIZE + blk->size;
+        list_remove(sim, b);
+        block_release(sim, b);
+        b = prev;
+    }
+    list_update(sim, b);
+    size_insert(sim, b);
+}
+
+/**
+ * Reads a trace file into memory
+ *
+ * @param path Trace path, "-" for stdin
+ * @param nops Receives the number of operations
+ * @return Array of operations; frees carry the size of their allocation
+ */
+static trace_op_t *read_trace(const char *path, size_t *nops) {
+    FILE *in = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    if (!in) {
+        perror(path);
+        exit(1);
+    }
+
+    trace_op_t *ops = NULL;
+    size_t count = 0, capacity = 0;
+    live_map_t sizes = { 0 }; // id -> request size, to size the frees
+    char line[128];
+
+    while (fgets(line, sizeof(line), in)) {
+        trace_op_t op = { 0 };
+        unsigned long id;
+        if (sscanf(line, "%c %lx %zu", &op.op, &id, &op.size) < 2) continue;
+        op.id = id;
+        if (op.op == 'f') {
+            size_t request = live_take(&sizes, op.id);
+            if (request == NIL) continue;
+            op.size = request;
+        } else if (op.op == 'm' || op.op == 'c') {
+            if (op.id == 0) continue; // failed allocation
+            live_put(&sizes, op.id, op.size);
+        } else {
+            continue;
+        }
+
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 4096;
+            ops = xrealloc(ops, capacity * sizeof(trace_op_t));
+        }
+        ops[count++] = op;
+    }
+
+    if (in != stdin) fclose(in);
+    free(sizes.keys);
+    free(sizes.values);
+    *nops = count;
+    return ops;
+}
+
+static void run(const trace_op_t *ops, size_t nops, policy_t policy,
+                size_t align, size_t mmap_threshold) {
+    sim_t sim = {
+        .policy = policy,
+        .align = align,
+        .mmap_threshold = mmap_threshold,
+        .spare = NIL,
+        .root = NIL,
+        .size_root = NIL,
+        .rover = NIL,
+        .seed = 2463534242u,
+        .map_top = (uint64_t)1 << 46,
+    };
+
+    for (size_t i = 0; i < nops; i++) {
+        if (ops[i].op == 'f') {
+            sim_free(&sim, ops[i].id, ops[i].size);
+        } else {
+            sim_malloc(&sim, ops[i].id, ops[i].size);
+        }
+    }
+
+    double frag = sim.peak_mapped ? 1.0 - (double)sim.live_at_peak / sim.peak_mapped : 0.0;
+    printf("%-6s %10zu %10zu %12zu %12zu %7.1f%% %14.1f %14.1f %8zu\n",
+           policy_names[policy], sim.nmalloc, sim.nfree, sim.peak_mapped, sim.peak_live,
+           frag * 100.0,
+           sim.nmalloc ? (double)sim.search_steps / sim.nmalloc : 0.0,
+           sim.nfree ? (double)sim.coalesce_steps / sim.nfree : 0.0,
+           sim.nmmap);
+
+    free(sim.blocks);
+    free(sim.live.keys);
+    free(sim.live.values);
+}
+
+static void usage(void) {
+    fprintf(stderr, "usage: simulate [-p first|best|next] [-a align] [-t mmap_threshold] trace\n");
+    exit(2);
+}
+
+//main function to run the simulator
+int main(int argc, char **argv) {
+    int policy = -1;
+    size_t align = 8;
+    size_t mmap_threshold = PAGE_SIZE;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "p:a:t:")) != -1) {
+        switch (opt) {
+        case 'p':
+            for (policy = 0; policy < NUM_POLICIES; policy++) {
+                if (strcmp(optarg, policy_names[policy]) == 0) break;
+            }
+            if (policy == NUM_POLICIES) usage();
+            break;
+        case 'a':
+            align = strtoul(optarg, NULL, 10);
+            if (align < 8 || (align & (align - 1))) usage();
+            break;
+        case 't':
+            mmap_threshold = strtoul(optarg, NULL, 10);
+            break;
+        default:
+            usage();
+        }
+    }
+    if (optind != argc - 1) usage();
+
+    size_t nops;
+    trace_op_t *ops = read_trace(argv[optind], &nops);
+
+    printf("%-6s %10s %10s %12s %12s %8s %14s %14s %8s\n",
+           "policy", "mallocs", "frees", "peak_mapped", "peak_live", "frag",
+           "search/malloc", "coalesce/free", "mmaps");
+    for (int p = 0; p < NUM_POLICIES; p++) {
+        if (policy == -1 || policy == p) run(ops, nops, p, align, mmap_threshold);
+    }
+
+    free(ops);
+    return 0;
+}
@@ -0,0 +1,150 @@
+/**
+ * Parametrized allocation workloads for the adversary and the benchmarks.
+ * Every workload runs against the real mymalloc()/myfree() and is measured
+ * through the allocator's own statistics (mymalloc_ctl "stats.*").
+ */
+
+// importing neccesary libararies
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include "malloc.h"
+#include "workload.h"
+
+#define WL_MAX_LIVE 8192  // enough for the largest parameters of any family
+
+const char *wl_family_names[WL_FAMILIES] = { "holes", "churn" };
+
+const char *wl_param_names[WL_FAMILIES][WL_PARAMS] = {
+    { "count", "size_a", "size_b", "stride", "refill" },
+    { "rounds", "batch", "small", "large", "keep" },
+};
+
+const long wl_param_min[WL_FAMILIES][WL_PARAMS] = {
+    { 16, 8, 8, 2, 8 },
+    { 1, 8, 8, 8, 2 },
+};
+
+const long wl_param_max[WL_FAMILIES][WL_PARAMS] = {
+    { 1024, 4000, 4000, 16, 4000 },
+    { 32, 256, 512, 8192, 16 },
+};
+
+static void *live[WL_MAX_LIVE];
+
+static size_t stat_value(const char *name) {
+    size_t value = 0;
+    mymalloc_ctl(name, &value, NULL);
+    return value;
+}
+
+/**
+ * Routes every call straight to the free lists
+ * Thread, zero-fill and batched-free caches would hide the list behaviour
+ * that the workloads are meant to measure.
+ */
+void wl_setup(void) {
+    size_t zero = 0;
+    bool enabled = true;
+    mymalloc_ctl("tcache.capacity", NULL, &zero);
+    mymalloc_ctl("zcache.capacity", NULL, &zero);
+    mymalloc_ctl("opt.free_batch", NULL, &zero);
+    mymalloc_ctl("stats.enabled", NULL, &enabled);
+}
+
+/**
+ * Holes: allocate 'count' blocks alternating size_a/size_b, free every
+ * 'stride'-th one, then allocate count/stride blocks of 'refill' bytes.
+ * When refill does not fit the holes, every refill walks past all of them.
+ */
+static size_t run_holes(const long *p, size_t *nlive, size_t *peak_alloc, size_t *peak_mapped) {
+    size_t count = p[0], stride = p[3], ops = 0, n = 0;
+
+    for (size_t i = 0; i < count; i++, ops++) {
+        live[n++] = mymalloc((i & 1) ? p[2] : p[1]);
+    }
+    for (size_t i = 0; i < count; i += stride, ops++) {
+        myfree(live[i]);
+        live[i] = NULL;
+    }
+    for (size_t i = 0; i < count / stride; i++, ops++) {
+        live[n++] = mymalloc(p[4]);
+    }
+
+    *peak_alloc = stat_value("stats.allocated");
+    *peak_mapped = stat_value("stats.mapped");
+    *nlive = n;
+    return ops;
+}
+
+/**
+ * Churn: 'rounds' times allocate 'batch' blocks alternating small/large
+ * and free all but every 'keep'-th. The survivors pin chunks and split
+ * the free space into many small, unmergeable pieces.
+ */
+static size_t run_churn(const long *p, size_t *nlive, size_t *peak_alloc, size_t *peak_mapped) {
+    size_t rounds = p[0], batch = p[1], keep = p[4], ops = 0, n = 0;
+
+    for (size_t r = 0; r < rounds; r++) {
+        size_t first = n;
+        for (size_t i = 0; i < batch; i++, ops++) {
+            live[n++] = mymalloc((i & 1) ? p[3] : p[2]);
+        }
+        for (size_t i = first; i < n; i++) {
+            if ((i - first) % keep == 0) continue;
+            myfree(live[i]);
+            live[i] = NULL;
+            ops++;
+        }
+    }
+
+    *peak_alloc = stat_value("stats.allocated");
+    *peak_mapped = stat_value("stats.mapped");
+    *nlive = n;
+    return ops;
+}
+
+/**
+ * Runs one workload and measures it
+ *
+ * @param wl Workload with parameters inside the family's ranges
+ * @param res Receives the measurements
+ * @return 0 on success, -1 for bad parameters
+ *
+ * Everything is freed and the heap trimmed afterwards, so consecutive
+ * runs start from an empty heap.
+ */
+int wl_run(const workload_t *wl, wl_result_t *res) {
+    if (wl->family >= WL_FAMILIES) return -1;
+    for (int i = 0; i < WL_PARAMS; i++) {
+        if (wl->p[i] < wl_param_min[wl->family][i] || wl->p[i] > wl_param_max[wl->family][i]) return -1;
+    }
+
+    size_t steps_before = stat_value("stats.search_steps") + stat_value("stats.coalesce_steps");
+    size_t mmap_before = stat_value("stats.nmmap");
+    size_t nlive = 0, peak_alloc = 0, peak_mapped = 0, ops;
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (wl->family == WL_HOLES) {
+        ops = run_holes(wl->p, &nlive, &peak_alloc, &peak_mapped);
+    } else {
+        ops = run_churn(wl->p, &nlive, &peak_alloc, &peak_mapped);
+    }
+    for (size_t i = 0; i < nlive; i++) {
+        if (live[i]) {
+            myfree(live[i]);
+            ops++;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    res->ops = ops;
+    res->steps_per_op = (double)(stat_value("stats.search_steps") + stat_value("stats.coalesce_steps") - steps_before) / ops;
+    res->frag = peak_mapped ? 1.0 - (double)peak_alloc / peak_mapped : 0.0;
+    res->nmmap = stat_value("stats.nmmap") - mmap_before;
+    res->seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    mymalloc_trim();
+    return 0;
+}
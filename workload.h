@@ -0,0 +1,41 @@
+#ifndef _WORKLOAD_H
+#define _WORKLOAD_H
+
+/* Parametrized allocation workloads shared by the adversary search and
+ * the benchmark suite. Each family interprets WL_PARAMS integers; the
+ * valid range of each is given by wl_param_min/wl_param_max.
+ */
+
+#include <stddef.h>
+
+typedef enum {
+    WL_HOLES,    /* fill, punch regular holes, refill with a misfitting size */
+    WL_CHURN,    /* rounds of alloc/free that keep a sparse survivor set */
+    WL_FAMILIES
+} wl_family_t;
+
+#define WL_PARAMS 5
+
+typedef struct workload {
+    const char *name;
+    wl_family_t family;
+    long p[WL_PARAMS];
+} workload_t;
+
+typedef struct wl_result {
+    size_t ops;          /* mymalloc + myfree calls */
+    double steps_per_op; /* free list nodes visited per call */
+    double frag;         /* 1 - allocated / mapped at the fullest point */
+    size_t nmmap;        /* chunks mapped */
+    double seconds;      /* wall time of the run */
+} wl_result_t;
+
+extern const char *wl_family_names[WL_FAMILIES];
+extern const char *wl_param_names[WL_FAMILIES][WL_PARAMS];
+extern const long wl_param_min[WL_FAMILIES][WL_PARAMS];
+extern const long wl_param_max[WL_FAMILIES][WL_PARAMS];
+
+void wl_setup(void);
+int wl_run(const workload_t *wl, wl_result_t *res);
+
+#endif /* ifndef _WORKLOAD_H */